@@ -0,0 +1,73 @@
+#pragma once
+#include "Common.h"
+#include <vector>
+
+namespace memoryPool
+{
+
+// 分配轨迹记录器
+// 把每次分配/释放（大小、线程、时间戳）写入紧凑的二进制日志，供 trace_replay 在不同分配器上重放。
+// 每个线程先写入自己的缓冲区，缓冲区满或线程退出时才加锁追加到文件，因此记录顺序只在线程内有序，
+// 重放时按时间戳排序。
+// MemoryPool 的接口只在以 MEMORY_POOL_TRACE 编译（CMake 选项 -DMEMORY_POOL_TRACE=ON）时才调用 record，
+// 否则记录点展开为空，不影响快速路径。
+class AllocTrace
+{
+public:
+    enum Op : uint8_t
+    {
+        OP_ALLOC = 1,
+        OP_FREE = 2,
+    };
+
+    // 日志中的一条记录，24 字节
+    struct Event
+    {
+        uint64_t timestamp;   // steady_clock 纳秒
+        uint64_t ptr;         // 内存块地址
+        uint32_t size;        // 大小，超过 4GB 的记为 UINT32_MAX
+        uint32_t thread : 24; // 记录器分配的线程编号，从 1 开始
+        uint32_t op : 8;      // Op
+    };
+
+    // 开始记录到 path，已在记录时先停止之前的记录
+    // 返回值: 文件无法打开时返回 false
+    static bool start(const char* path);
+
+    // 停止记录，写出所有线程缓冲区中的记录并关闭文件
+    static void stop();
+
+    static bool isActive()
+    {
+        return active_.load(std::memory_order_relaxed);
+    }
+
+    // 记录一次分配或释放，未开启时立即返回
+    static void record(Op op, void* ptr, size_t size)
+    {
+        if (__builtin_expect(isActive(), 0))
+        {
+            append(op, ptr, size);
+        }
+    }
+
+    // 读取日志中的全部记录（按文件顺序）
+    // 返回值: 文件不存在或格式不对时返回 false
+    static bool readLog(const char* path, std::vector<Event>& events);
+
+private:
+    static void append(Op op, void* ptr, size_t size);
+
+    static inline std::atomic<bool> active_{false};
+};
+
+static_assert(sizeof(AllocTrace::Event) == 24, "trace events are expected to be 24 bytes");
+
+} // namespace memoryPool
+
+// MemoryPool 接口中的记录点
+#ifdef MEMORY_POOL_TRACE
+#define MEMORY_POOL_TRACE_EVENT(op, ptr, size) ::memoryPool::AllocTrace::record(op, ptr, size)
+#else
+#define MEMORY_POOL_TRACE_EVENT(op, ptr, size) ((void)0)
+#endif
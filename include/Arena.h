@@ -0,0 +1,110 @@
+#pragma once
+#include "Common.h"
+#include "PageCache.h"
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace memoryPool
+{
+
+// 单调内存区
+// 从 PageCache 取整段 span，在其中顺序推进指针分配，没有逐对象释放：请求结束时整体 reset()，
+// 适合生命周期相同的一批对象（例如一次请求内的全部临时数据）。快速路径只有对齐、比较和加法。
+// 可以用 save() 记下当前位置，之后 rollback() 回到该位置，之间分配的对象全部作废。
+// reset() 和析构时把 span 还给页缓存，reset() 保留一段 span 供下次复用。
+// 不是线程安全的，通常每个请求或每个线程一个。
+class Arena
+{
+public:
+    // 默认每段 span 的页数
+    static constexpr size_t DEFAULT_SPAN_PAGES = 16; // 64KB
+
+    // 记录的位置
+    struct Savepoint
+    {
+        void* chunk;  // 当时正在使用的 span
+        char* cursor; // 当时的分配位置
+    };
+
+    explicit Arena(size_t spanPages = DEFAULT_SPAN_PAGES) : spanPages_(spanPages ? spanPages : 1) {}
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // 分配 size 字节，alignment 须为 2 的幂；页缓存分配失败时返回 nullptr
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+    {
+        // 0 大小的请求也需要返回一个独立的地址
+        size = size ? size : 1;
+
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(cursor_) + alignment - 1) & ~(alignment - 1);
+        uintptr_t limit = reinterpret_cast<uintptr_t>(limit_);
+        if (__builtin_expect(aligned <= limit && size <= limit - aligned, 1))
+        {
+            cursor_ = reinterpret_cast<char*>(aligned + size);
+            return reinterpret_cast<void*>(aligned);
+        }
+        return allocateSlow(size, alignment);
+    }
+
+    // 在内存区中构造一个 T 对象；析构函数不会被调用，只适合平凡析构或不需要析构的类型
+    template <typename T, typename... Args>
+    T* create(Args&&... args)
+    {
+        void* memory = allocate(sizeof(T), alignof(T));
+        if (!memory) throw std::bad_alloc();
+        return new (memory) T(std::forward<Args>(args)...);
+    }
+
+    Savepoint save() const
+    {
+        return {current_, cursor_};
+    }
+
+    // 回到 save() 记下的位置，之后取得的 span 还给页缓存
+    void rollback(const Savepoint& savepoint);
+
+    // 作废全部对象，保留一段 span 供复用，其余还给页缓存
+    void reset();
+
+    // 已分配出去的字节数（含对齐填充）与持有的 span 字节数
+    size_t bytesUsed() const;
+    size_t bytesReserved() const { return reservedPages_ * PageCache::PAGE_SIZE; }
+
+private:
+    // 每段 span 开头的链表头，链接到上一段
+    struct Chunk
+    {
+        Chunk* prev;
+        size_t numPages;
+        char*  cursor; // 切换到下一段时的分配位置，用于统计已分配字节数
+    };
+
+    // 当前 span 放不下时取一段新的 span
+    void* allocateSlow(size_t size, size_t alignment);
+
+    // 归还一段 span：标准大小的替换备用 span，其余还给页缓存
+    void releaseChunk(Chunk* chunk);
+
+    static char* chunkBegin(Chunk* chunk)
+    {
+        return reinterpret_cast<char*>(chunk) + sizeof(Chunk);
+    }
+
+    static char* chunkEnd(Chunk* chunk)
+    {
+        return reinterpret_cast<char*>(chunk) + chunk->numPages * PageCache::PAGE_SIZE;
+    }
+
+private:
+    size_t spanPages_;
+    Chunk* current_ = nullptr; // 正在使用的 span，链接到更早的 span
+    Chunk* spare_ = nullptr;   // 备用 span
+    char*  cursor_ = nullptr;  // 下一次分配的位置
+    char*  limit_ = nullptr;   // 当前 span 的末尾
+    size_t reservedPages_ = 0; // 持有的页数（含备用）
+};
+
+} // namespace memoryPool
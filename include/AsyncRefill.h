@@ -0,0 +1,137 @@
+#pragma once
+#include "Common.h"
+#include <atomic>
+
+namespace memoryPool
+{
+
+class CentralCache;
+
+// 单生产者单消费者环形队列，N 须为 2 的幂
+template <typename T, size_t N>
+class SpscRing
+{
+    static_assert((N & (N - 1)) == 0, "capacity must be a power of two");
+
+public:
+    // 生产者调用，队列满时返回 false
+    bool push(const T& value)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == N) return false;
+        slots_[tail & (N - 1)] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者调用，队列空时返回 false
+    bool pop(T& value)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) return false;
+        value = slots_[head & (N - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    bool full() const
+    {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire) == N;
+    }
+
+    // 两端都确定不再访问时清空
+    void clear()
+    {
+        head_.store(tail_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> head_{0}; // 消费者位置
+    alignas(64) std::atomic<size_t> tail_{0}; // 生产者位置
+    T slots_[N];
+};
+
+// 一个线程缓存的异步补充信箱
+// 所属线程把补充请求放入 requests，后台线程从中心缓存取好一批内存块后放入 batches，
+// 所属线程在本地链表变短或未命中时取出。两个队列各自只有一个生产者和一个消费者。
+struct RefillMailbox : SystemAllocated
+{
+    static constexpr size_t CAPACITY = 64;
+
+    struct Request
+    {
+        uint32_t index;        // 大小类别
+        uint32_t count;        // 期望的内存块个数
+        CentralCache* central; // 所属线程投递时使用的中心缓存（NUMA 分片下随线程所在节点变化）
+    };
+
+    struct Batch
+    {
+        void*    head;  // 内存块链表，中心缓存内存不足时为 nullptr
+        void*    tail;
+        uint32_t index;
+        uint32_t count;
+    };
+
+    SpscRing<Request, CAPACITY> requests;
+    SpscRing<Batch, CAPACITY> batches;
+
+    // 所属线程是否开启异步补充；关闭后后台线程不再访问本信箱
+    std::atomic<bool> active{false};
+    // 后台线程正在处理本信箱
+    std::atomic<bool> busy{false};
+
+    // 补充得到的 span 的所属者（ThreadCache）
+    void* owner = nullptr;
+    // 全部信箱链表
+    RefillMailbox* next = nullptr;
+
+    // 已请求、尚未取回的大小类别位图，只由所属线程访问
+    uint64_t pending[FREE_LIST_SIZE / 64] = {};
+};
+
+// 异步补充
+// 开启后，线程缓存某个大小类别的本地链表低于半个批量时向后台线程投递补充请求，
+// 后台线程代为调用 CentralCache::fetchRange（以及可能的 PageCache 分配和 mmap），
+// 把整批内存块放回该线程的信箱。所属线程只做无锁的队列操作，中心缓存的锁和系统调用都离开了请求线程。
+// 后台线程空闲时休眠，最长 1 毫秒后自行醒来检查；只有它在休眠时投递请求才需要一次唤醒。
+class AsyncRefill
+{
+public:
+    // 为 owner 开启异步补充（首次调用时启动后台线程），mailbox 为 nullptr 时新建
+    // 每个请求携带取内存块的中心缓存，见 RefillMailbox::Request
+    static RefillMailbox* attach(RefillMailbox* mailbox, void* owner);
+
+    // 关闭异步补充，返回后后台线程不会再访问该信箱；信箱中已送达的批量由调用者取出
+    static void detach(RefillMailbox* mailbox);
+
+    // 有新请求时调用
+    static void wake()
+    {
+        if (sleeping_.load(std::memory_order_acquire)) wakeHelper();
+    }
+
+    // 后台线程累计送达的批量数
+    static size_t deliveredBatches()
+    {
+        return delivered_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static void wakeHelper();
+    static void helperLoop();
+
+    // 处理一个信箱中的请求，返回是否处理了请求
+    static bool serve(RefillMailbox* mailbox);
+
+    static inline std::atomic<RefillMailbox*> mailboxes_{nullptr};
+    static inline std::atomic<bool> sleeping_{false};
+    static inline std::atomic<size_t> delivered_{0};
+};
+
+} // namespace memoryPool
@@ -1,5 +1,7 @@
 #pragma once
 #include "Common.h"
+#include "PageCache.h"
+#include "Stats.h"
 #include <mutex>
 
 // 定义 memoryPool 命名空间，用于封装内存池相关的类和功能
@@ -9,6 +11,16 @@ namespace memoryPool
 // 中心缓存类
 // CentralCache 是内存池中的共享层，负责管理内存块的分配和回收，
 // 为线程缓存提供内存块，并将线程缓存归还的内存块重新分配给其他线程。
+//
+// 每个大小类别以 slab（切分成等大内存块的 span）为单位管理空闲内存：
+// span 的空闲位图记录哪些内存块空闲，span 按满度挂在部分使用 / 全满 / 全空链表上。
+// 分配时优先从最满的部分使用 slab 取块，使其他 slab 尽快变空并归还给页缓存，
+// 同一 slab 内按地址顺序取块，保证批量取出的内存块相邻。
+//
+// slab 的起始地址都按页对齐，若内存块都从 span 起点排起，各 slab 的第 i 个内存块会落在相同的 L1 组上。
+// 因此每个 slab 的第一个内存块相对起点偏移一个"颜色"：偏移取自切分后的剩余空间，按缓存行步进，
+// 每个大小类别依次轮换（起点按类别错开）。偏移是内存块自然对齐（大小的最低位，最多一页）的倍数，
+// 按大小取整实现的对齐分配不受影响；因此大小为整页倍数的类别无法着色。
 class CentralCache
 {
 public:
@@ -16,32 +28,40 @@ public:
     // 使用静态局部变量实现线程安全的单例模式
     static CentralCache& getInstance()
     {
-        static CentralCache instance;
+        static CentralCache instance(PageCache::getInstance());
         return instance;
     }
 
     // 从中心缓存获取一批内存块
     // 参数 index: 自由链表的索引，表示请求的内存块大小类别
     // 参数 batchNum: 请求的内存块数量
-    // 返回值: 指向获取的内存块链表的指针
+    // 返回值: 指向获取的内存块链表的指针（以 nullptr 结尾，可能少于 batchNum 个）
     void* fetchRange(size_t index, size_t batchNum);
 
     // 将一批内存块归还到中心缓存
-    // 参数 start: 归还的内存块链表的起始地址
-    // 参数 size: 单个内存块的大小（以字节为单位）
-    // 参数 bytes: 归还的内存块总字节数（此处未直接使用，可能是为了兼容性保留）
-    void returnRange(void* start, size_t size, size_t bytes);
+    // 参数 start: 归还的内存块链表的起始地址（以 nullptr 结尾）
+    // 参数 size: 归还的内存块总字节数（此处未直接使用，可能是为了兼容性保留）
+    // 参数 index: 自由链表的索引
+    void returnRange(void* start, size_t size, size_t index);
+
+    // 汇总每个大小类别 slab 中的空闲字节数（逐个类别加锁）
+    // stats.classes 须已按大小类别索引展开为 FREE_LIST_SIZE 项
+    void collectStats(PoolStats& stats);
+
+    // 为大小类别预先切分 slab，直到空闲内存块不少于 count 个
+    // 新的全空 slab 直接保留，不受 MAX_EMPTY_SPANS 限制；页缓存分配失败时返回 false
+    bool reserve(size_t index, size_t count);
+
+    // 把全部大小类别的全空 slab（包括 MAX_EMPTY_SPANS 保留的）归还给页缓存，内存压力下调用
+    // 返回值: 归还的字节数
+    size_t releaseEmptySpans();
 
 private:
     // 私有构造函数
-    // 防止外部直接实例化 CentralCache，只能通过 getInstance() 获取实例
-    CentralCache()
+    // 防止外部直接实例化 CentralCache，只能通过 getInstance() 获取实例（Heap 为每个堆创建独立实例）
+    // 参数 pageCache: 为 slab 提供 span 的页缓存
+    explicit CentralCache(PageCache& pageCache) : pageCache_(pageCache)
     {
-        // 初始化中心缓存的自由链表，所有原子指针设为 nullptr
-        for (auto& ptr : centralFreeList_)
-        {
-            ptr.store(nullptr, std::memory_order_relaxed);
-        }
         // 初始化所有自旋锁为未锁定状态
         for (auto& lock : locks_)
         {
@@ -49,20 +69,87 @@ private:
         }
     }
 
-    // 从页缓存获取内存
-    // 参数 size: 请求的内存块大小（以字节为单位）
-    // 返回值: 指向从页缓存获取的内存的指针
-    void* fetchFromPageCache(size_t size);
+    friend class Heap;
+    friend class Numa;
+
+    // 丢弃全部 slab：只释放空闲位图，span 本身由页缓存的 releaseAll 一并回收
+    void releaseAll();
+
+    // 部分使用 slab 按满度分成的档数
+    static constexpr int PARTIAL_LISTS = 4;
+    // 全满、全空 slab 链表的编号
+    static constexpr int FULL_LIST = PARTIAL_LISTS;
+    static constexpr int EMPTY_LIST = PARTIAL_LISTS + 1;
+    static constexpr int NUM_LISTS = PARTIAL_LISTS + 2;
+    // 每个大小类别最多保留的全空 slab 数，多余的归还给页缓存
+    static constexpr size_t MAX_EMPTY_SPANS = 1;
+    // 着色的最小步长（一个缓存行）和期望的着色范围；剩余空间不足时舍弃末尾的内存块补足，
+    // 舍弃的字节数不超过 span 的 1/MAX_COLOR_WASTE
+    static constexpr size_t COLOR_STEP = 64;
+    static constexpr size_t COLOR_SPACE = 1024;
+    static constexpr size_t MAX_COLOR_WASTE = 16;
+
+    // 双向 span 链表
+    struct SpanList
+    {
+        Span*  head = nullptr;
+        size_t count = 0;
+    };
+
+    // 一个大小类别的全部 slab
+    struct ClassSlabs
+    {
+        std::array<SpanList, NUM_LISTS> lists;
+        std::atomic<size_t> nextColor{0}; // 下一个新 slab 使用的颜色序号，新 slab 在类别锁之外切分
+    };
+
+    // 从页缓存获取一个新 span 并初始化为 slab，不访问类别的 slab 链表，调用时不持有类别锁
+    // 参数 index: 大小类别索引
+    // 返回值: 新的 slab（尚未加入任何链表），失败时返回 nullptr
+    Span* fetchFromPageCache(size_t index);
+
+    // 调用者持有类别锁：释放锁后调用 fetchFromPageCache，返回前（包括抛出异常时）重新加锁
+    // 期间其他线程可能已补充或取走内存块，调用者须重新检查 slab 链表
+    Span* fetchUnlocked(size_t index);
+
+    // 选择取块的 slab：最满的部分使用 slab，其次是全空 slab，都没有时返回 nullptr
+    static Span* pickSpan(ClassSlabs& slabs);
+
+    // 大小类别的空闲内存块数
+    static size_t freeBlocksOf(const ClassSlabs& slabs);
+
+    // 把全空的 slab 归还给页缓存
+    void releaseToPageCache(Span* span);
+
+    // 从 slab 中按地址顺序取出最多 n 个空闲内存块，接到链表 [head, tail] 的尾部
+    // 返回值: 实际取出的个数
+    size_t takeBlocks(Span* span, size_t n, void*& head, void*& tail);
+
+    // 根据 slab 当前的满度把它移动到对应的链表
+    void updateSpanList(ClassSlabs& slabs, Span* span);
+
+    // 计算 slab 应当所在的链表
+    static int listFor(const Span* span);
+
+    static void listPush(SpanList& list, Span* span);
+    static void listRemove(SpanList& list, Span* span);
+
+    // 计算大小类别对应的 span 页数
+    static size_t spanPagesFor(size_t size);
+
+    // 计算 slab 的切分方式：可切出的内存块数、可用的颜色数及颜色步长
+    static void slabLayout(size_t size, size_t numPages, size_t& blocks, size_t& colors, size_t& step);
 
 private:
-    // 中心缓存的自由链表数组
-    // 使用原子指针支持线程安全的操作，FREE_LIST_SIZE 定义了大小类别的数量
-    std::array<std::atomic<void*>, FREE_LIST_SIZE> centralFreeList_;
+    // 为 slab 提供 span 的页缓存
+    PageCache& pageCache_;
+
+    // 每个大小类别的 slab 链表
+    std::array<ClassSlabs, FREE_LIST_SIZE> slabs_;
 
     // 用于同步的自旋锁数组
-    // 每个自由链表对应一个自旋锁，保护对该链表的并发访问
+    // 每个大小类别对应一个自旋锁，保护对该类别 slab 的并发访问
     std::array<std::atomic_flag, FREE_LIST_SIZE> locks_;
 };
 
 } // namespace memoryPool
-
@@ -1,7 +1,11 @@
 #pragma once // 保证头文件只被编译一次，防止重复定义
 #include <cstddef> // 包含标准类型定义，如 size_t
 #include <atomic> // 包含原子操作相关的头文件 (虽然在这个代码片段中没有直接使用，但可能在其他部分会用到)
+#include <algorithm> // 包含 std::max
 #include <array> // 包含 std::array 容器相关的头文件 (虽然在这个代码片段中没有直接使用，但可能在其他部分会用到)
+#include <cstdint> // 包含 uintptr_t 等定长整数类型
+#include <cstdlib> // 包含 malloc/free
+#include <new> // 包含 std::bad_alloc
 
 namespace memoryPool // 定义一个名为 memoryPool 的命名空间，用于组织相关的类和常量
 {
@@ -22,7 +26,7 @@ struct BlockHeader
 class SizeClass
 {
 public:
-    static size_t roundUp(size_t bytes) // 静态方法，用于将给定的字节数向上对齐到 ALIGNMENT 的倍数
+    static constexpr size_t roundUp(size_t bytes) // 静态方法，用于将给定的字节数向上对齐到 ALIGNMENT 的倍数
     {
         return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
         // 位运算实现向上对齐：
@@ -31,7 +35,7 @@ public:
         // 进行与运算后，会将 bytes 的低位清零，从而实现向上对齐。
     }
 
-    static size_t getIndex(size_t bytes) // 静态方法，用于根据给定的字节数获取一个索引，可能用于选择不同大小的内存块链表
+    static constexpr size_t getIndex(size_t bytes) // 静态方法，用于根据给定的字节数获取一个索引，可能用于选择不同大小的内存块链表
     {
         // 确保bytes至少为ALIGNMENT，防止计算出负数或不合理的索引
         bytes = std::max(bytes, ALIGNMENT);
@@ -41,4 +45,45 @@ public:
     }
 };
 
+// 内部元数据分配器
+// 内存池自身的元数据（Span、std::map 节点等）直接通过 malloc/free 分配，
+// 这样在替换全局 operator new 之后，内存池内部不会递归进入自身（否则会在 PageCache 的锁内死锁）。
+template <typename T>
+struct SystemAllocator
+{
+    using value_type = T;
+
+    SystemAllocator() = default;
+    template <typename U>
+    SystemAllocator(const SystemAllocator<U>&) {}
+
+    T* allocate(size_t n)
+    {
+        void* ptr = std::malloc(n * sizeof(T));
+        if (!ptr) throw std::bad_alloc();
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_t) { std::free(ptr); }
+
+    template <typename U>
+    bool operator==(const SystemAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const SystemAllocator<U>&) const { return false; }
+};
+
+// 继承该类型的元数据对象使用 malloc/free 作为 new/delete 的实现，原因同上
+struct SystemAllocated
+{
+    static void* operator new(size_t size)
+    {
+        return SystemAllocator<char>().allocate(size);
+    }
+
+    static void operator delete(void* ptr)
+    {
+        std::free(ptr);
+    }
+};
+
 } // namespace memoryPool
@@ -0,0 +1,78 @@
+#pragma once
+#include "Common.h"
+#include "Stats.h"
+#include <atomic>
+#include <mutex>
+#include <pthread.h>
+
+namespace memoryPool
+{
+
+class PageCache;
+class CentralCache;
+class ThreadCache;
+
+// 独立堆
+// 每个堆拥有自己的页缓存和中心缓存，每个线程在每个堆上有独立的线程缓存（通过堆自己的 pthread key 查找），
+// 不同堆的内存互不混用，可以分别统计。大对象（超过 MAX_BYTES）也从堆的页缓存按页分配。
+// destroy() 不逐个释放对象，而是按段解除堆从操作系统映射的全部内存、删除所有 span 元数据，开销与 span 数成正比。
+//
+// 约束：
+// - 堆上分配的对象只能通过同一个堆的 deallocate 释放，且 size 与分配时一致
+// - destroy() 和析构时不能有其他线程正在该堆上分配或释放；destroy() 之后堆可以继续使用
+// - 每个堆占用一个 pthread key 和约 3MB 的中心缓存元数据（每个大小类别的 slab 链表）
+class Heap
+{
+public:
+    Heap();
+    ~Heap();
+
+    Heap(const Heap&) = delete;
+    Heap& operator=(const Heap&) = delete;
+
+    // 分配指定大小的内存块
+    void* allocate(size_t size);
+
+    // 释放内存块，size 必须与分配时一致
+    void deallocate(void* ptr, size_t size);
+
+    // 释放堆中的全部内存，所有已分配的对象随之失效
+    void destroy();
+
+    // 汇总本堆三层缓存的统计
+    PoolStats getStats();
+
+private:
+    // 当前线程在本堆上的线程缓存，第一次使用时创建
+    ThreadCache* threadCache()
+    {
+        void* cache = pthread_getspecific(key_);
+        if (__builtin_expect(cache != nullptr, 1)) return static_cast<ThreadCache*>(cache);
+        return createThreadCache();
+    }
+
+    ThreadCache* createThreadCache();
+
+    // 线程退出时调用：归还线程缓存的内存块，实例留给本堆的其他线程复用
+    static void releaseThreadCache(void* cache);
+
+    // 大对象按页分配的页数
+    static size_t largePages(size_t size);
+
+private:
+    PageCache*    pageCache_;
+    CentralCache* centralCache_;
+
+    // 查找当前线程在本堆上的线程缓存
+    pthread_key_t key_;
+
+    // 保护以下两个实例链表
+    std::mutex mutex_;
+    ThreadCache* instances_ = nullptr; // 本堆创建过的全部线程缓存（经 nextInstance_ 相连）
+    ThreadCache* recycled_ = nullptr;  // 线程已退出、可复用的线程缓存（经 nextRecycled_ 相连）
+
+    std::atomic<size_t> largeAllocs_{0};
+    std::atomic<size_t> largeFrees_{0};
+};
+
+} // namespace memoryPool
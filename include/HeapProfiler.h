@@ -0,0 +1,83 @@
+#pragma once
+#include "Common.h"
+#include <cstdio>
+#include <vector>
+
+namespace memoryPool
+{
+
+// 采样堆分析器
+// 每个线程维护一个字节倒计数（见 ThreadCache::bytesUntilSample_），每分配约 sampleRate 字节
+// 按几何分布随机抽中一次分配。被抽中的对象不从普通的大小类别中分配，而是放在一块独立预留的
+// 地址区间里，因此释放时只需一次区间比较即可识别，未被抽中的分配和释放不需要任何额外查找。
+// 每个采样记录保存对象大小、分配时的调用栈和时间戳，可以按 pprof 兼容的格式导出存活的采样对象。
+class HeapProfiler
+{
+public:
+    // 默认平均采样间隔（字节）
+    static constexpr size_t DEFAULT_SAMPLE_RATE = 512 * 1024;
+    // 记录的最大调用栈深度
+    static constexpr int MAX_STACK_DEPTH = 32;
+
+    // 一个存活的采样对象
+    struct Sample
+    {
+        void*    ptr;        // 对象地址
+        size_t   size;       // 对象大小
+        uint64_t timestamp;  // 分配时刻（steady_clock 纳秒）
+        int      depth;      // 调用栈深度
+        void*    stack[MAX_STACK_DEPTH];
+    };
+
+    // 开始采样，sampleRate 为平均采样间隔（字节）
+    // 各线程在当前倒计数耗尽后才开始按新的间隔采样
+    static void start(size_t sampleRate = DEFAULT_SAMPLE_RATE);
+
+    // 停止采样，已采样的对象仍被跟踪直到释放
+    static void stop();
+
+    static bool isActive()
+    {
+        return active_.load(std::memory_order_relaxed);
+    }
+
+    static size_t sampleRate()
+    {
+        return sampleRate_.load(std::memory_order_relaxed);
+    }
+
+    // 判断指针是否为采样对象：采样区间未预留时恒为 false
+    static bool isSampled(void* ptr)
+    {
+        uintptr_t offset = reinterpret_cast<uintptr_t>(ptr) - regionBase_.load(std::memory_order_relaxed);
+        return offset < regionSize_.load(std::memory_order_relaxed);
+    }
+
+    // 在采样区间中分配一个对象并记录调用栈，区间已满时返回 nullptr
+    static void* allocateSampled(size_t size);
+
+    // 释放采样对象并删除其记录
+    static void deallocateSampled(void* ptr);
+
+    // 查询采样对象的大小
+    static size_t sampledObjectSize(void* ptr);
+
+    // 按几何分布生成下一次采样前的字节数，state 为调用线程的随机数状态
+    static size_t nextSampleInterval(uint64_t& state);
+
+    // 获取所有存活采样对象的快照
+    static std::vector<Sample, SystemAllocator<Sample>> getSamples();
+
+    // 以 pprof 旧版堆文本格式（heap_v2）输出存活的采样对象，附带 /proc/self/maps 供符号化
+    static void dump(FILE* out);
+
+private:
+    // 采样区间的起始地址和大小，预留后不再改变
+    static inline std::atomic<uintptr_t> regionBase_{0};
+    static inline std::atomic<size_t> regionSize_{0};
+
+    static inline std::atomic<bool> active_{false};
+    static inline std::atomic<size_t> sampleRate_{DEFAULT_SAMPLE_RATE};
+};
+
+} // namespace memoryPool
@@ -0,0 +1,125 @@
+#pragma once
+#include "Common.h"
+#include <cstdio>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace memoryPool
+{
+
+// 各层的计时点
+enum class Probe : int
+{
+    THREAD_CACHE_ALLOC,  // ThreadCache 分配快速路径（本地链表命中）
+    THREAD_CACHE_FREE,   // ThreadCache 释放快速路径（未触发归还）
+    FETCH_FROM_CENTRAL,  // ThreadCache::fetchFromCentralCache
+    CENTRAL_FETCH_WAIT,  // CentralCache::fetchRange 等锁时间
+    CENTRAL_FETCH_HOLD,  // CentralCache::fetchRange 持锁时间
+    CENTRAL_RETURN_WAIT, // CentralCache::returnRange 等锁时间
+    CENTRAL_RETURN_HOLD, // CentralCache::returnRange 持锁时间
+    PAGE_ALLOCATE_SPAN,  // PageCache::allocateSpan（含等锁）
+    SYSTEM_ALLOC,        // PageCache::systemAlloc（mmap 与缺页）
+    COUNT
+};
+
+// 分层计时
+// 以 MEMORY_POOL_INSTRUMENT 编译（CMake 选项 -DMEMORY_POOL_INSTRUMENT=ON）时，各层在计时点读取 TSC，
+// 把耗时（周期数）按 log2 分档记入当前线程的直方图；dump 时合并所有线程的直方图。
+// 直方图只由所属线程写入，合并时不加锁读取，结果是近似快照。未开启该选项时计时点展开为空。
+class Instrument
+{
+public:
+    static constexpr int NUM_BUCKETS = 64;
+    static constexpr int NUM_PROBES = static_cast<int>(Probe::COUNT);
+
+    // 一个计时点的直方图，第 i 档统计耗时在 [2^(i-1), 2^i) 周期内的次数（第 0 档为 0 周期）
+    struct Histogram
+    {
+        uint64_t buckets[NUM_BUCKETS];
+        uint64_t count;
+        uint64_t totalCycles;
+        uint64_t maxCycles;
+    };
+
+    // 读取时间戳计数器
+    static uint64_t now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // 记录一次耗时
+    static void record(Probe probe, uint64_t cycles)
+    {
+        Histogram& h = threadHistograms()[static_cast<int>(probe)];
+        int bucket = cycles ? std::min(64 - __builtin_clzll(cycles), NUM_BUCKETS - 1) : 0;
+        h.buckets[bucket]++;
+        h.count++;
+        h.totalCycles += cycles;
+        if (cycles > h.maxCycles) h.maxCycles = cycles;
+    }
+
+    // 合并所有线程的直方图，out 须有 NUM_PROBES 项
+    static void merge(Histogram* out);
+
+    // 清零所有线程的直方图
+    static void reset();
+
+    // 以可读格式输出合并后的直方图
+    static void dump(FILE* out);
+
+    static const char* probeName(Probe probe);
+
+private:
+    // 当前线程的直方图数组，第一次使用时注册
+    static Histogram* threadHistograms()
+    {
+        Histogram* histograms = tlsHistograms_;
+        if (__builtin_expect(histograms != nullptr, 1)) return histograms;
+        return registerThread();
+    }
+
+    static Histogram* registerThread();
+
+    // 线程退出时把直方图组留给新线程复用
+    static void releaseThread(void* group);
+
+    __attribute__((tls_model("initial-exec")))
+    static inline thread_local Histogram* tlsHistograms_ = nullptr;
+};
+
+// 作用域计时：析构时记录从构造到析构的耗时，用于有多个返回点的函数
+class ScopedProbe
+{
+public:
+    explicit ScopedProbe(Probe probe) : probe_(probe), start_(Instrument::now()) {}
+    ~ScopedProbe() { Instrument::record(probe_, Instrument::now() - start_); }
+
+    ScopedProbe(const ScopedProbe&) = delete;
+    ScopedProbe& operator=(const ScopedProbe&) = delete;
+
+private:
+    Probe probe_;
+    uint64_t start_;
+};
+
+} // namespace memoryPool
+
+// 计时点：START 读取起始时间，END 记录从起始时间到现在的耗时，SCOPE 记录到当前作用域结束的耗时
+#ifdef MEMORY_POOL_INSTRUMENT
+#define MEMORY_POOL_PROBE_START(var) uint64_t var = ::memoryPool::Instrument::now()
+#define MEMORY_POOL_PROBE_END(probe, var) \
+    ::memoryPool::Instrument::record(::memoryPool::Probe::probe, ::memoryPool::Instrument::now() - (var))
+#define MEMORY_POOL_PROBE_SCOPE(probe) ::memoryPool::ScopedProbe probeScope_##probe(::memoryPool::Probe::probe)
+#else
+#define MEMORY_POOL_PROBE_START(var) ((void)0)
+#define MEMORY_POOL_PROBE_END(probe, var) ((void)0)
+#define MEMORY_POOL_PROBE_SCOPE(probe) ((void)0)
+#endif
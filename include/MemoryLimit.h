@@ -0,0 +1,77 @@
+#pragma once
+#include "Common.h"
+#include <string>
+
+namespace memoryPool
+{
+
+// 内存压力级别
+enum class MemoryPressure
+{
+    NONE,
+    SOFT, // 超过软限制：主动归还缓存的内存
+    HARD, // 触及硬限制：新的内存无法分配
+};
+
+// 压力回调，参数为压力级别和当前驻留字节数；在不持有内存池任何锁的位置调用，可以分配和释放内存
+using PressureCallback = void (*)(MemoryPressure level, size_t residentBytes, void* arg);
+
+// 压力监视器配置（见 MemoryLimit::startWatcher），路径为空表示不读取该文件
+struct PressureWatcherConfig
+{
+    // PSI 文件：cgroup v2 的 memory.pressure，或系统级的 /proc/pressure/memory
+    // some avg10（最近 10 秒内至少一个任务因内存停顿的时间百分比）达到 someThreshold 时视为软压力，
+    // full avg10（全部任务同时停顿）达到 fullThreshold 时视为硬压力
+    std::string pressurePath = "/sys/fs/cgroup/memory.pressure";
+    double someThreshold = 10.0;
+    double fullThreshold = 5.0;
+
+    // cgroup 的内存上限和当前用量，用量达到上限的 softRatio / hardRatio 时视为软 / 硬压力
+    std::string maxPath = "/sys/fs/cgroup/memory.max";
+    std::string currentPath = "/sys/fs/cgroup/memory.current";
+    double softRatio = 0.8;
+    double hardRatio = 0.95;
+
+    // 轮询间隔（毫秒）
+    uint64_t intervalMs = 1000;
+};
+
+// 内存限制与压力处理
+// 页缓存在驻留字节数（映射的字节数减去已用 MADV_DONTNEED 归还的字节数）超过软限制时登记软压力，
+// 超过硬限制时拒绝分配并登记硬压力。登记的压力由线程下一次进入分配慢速路径时处理（此时不持有任何锁）：
+// 通知全部线程缓存在各自的下一次慢速路径中清空，把中心缓存的全空 slab 归还页缓存，
+// 再把页缓存的全部空闲 span 以 MADV_DONTNEED 归还操作系统，然后调用压力回调并再归还一次。
+// 因硬限制分配失败时同样处理一次后重试。软压力的处理最多每 100 毫秒一次。
+class MemoryLimit
+{
+public:
+    // 设置全局内存池的软、硬限制（字节，0 表示不限制）
+    static void setLimits(size_t softBytes, size_t hardBytes);
+
+    // 设置压力回调，nullptr 表示取消
+    static void setCallback(PressureCallback callback, void* arg);
+
+    // 立即归还：请求全部线程缓存清空（当前线程立即执行），归还中心缓存的全空 slab 和页缓存的空闲页
+    // 返回值: 本次以 MADV_DONTNEED 归还的字节数
+    static size_t releaseFreeMemory();
+
+    // 按压力级别处理一次（归还并调用回调）；其他线程正在处理时直接返回 0
+    static size_t relieve(MemoryPressure level);
+
+    // 线程缓存慢速路径调用：处理页缓存登记的压力
+    static void relievePending();
+
+    // 线程缓存从中心缓存取内存失败后调用：失败由硬限制引起时处理一次，返回 true 表示值得重试
+    static bool relieveAfterFailure();
+
+    // 读取一次配置中的文件，返回当前的压力级别
+    static MemoryPressure evaluate(const PressureWatcherConfig& config);
+
+    // 启动后台监视线程，按间隔读取 PSI 和 cgroup 文件，检测到压力时调用 relieve；已在运行时先停止
+    static void startWatcher(const PressureWatcherConfig& config);
+
+    // 停止后台监视线程
+    static void stopWatcher();
+};
+
+} // namespace memoryPool
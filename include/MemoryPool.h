@@ -1,6 +1,16 @@
 #pragma once // 保证头文件只被编译一次，防止重复定义
 
 #include "ThreadCache.h" // 包含 ThreadCache 类的头文件，该类负责实际的线程本地内存管理
+#include "PageCache.h" // 包含 PageCache 类的头文件，用于按指针查询内存块大小
+#include "Stats.h" // 包含统计结构 PoolStats
+#include "AllocTrace.h" // 包含分配轨迹记录点
+#include "Realtime.h" // 包含实时模式配置
+#include "MemoryLimit.h" // 包含内存限制与压力监视
+#include "Numa.h" // 包含 NUMA 分片
+#include "PersistentHeap.h" // 包含持久化堆
+#include "SharedPool.h" // 包含共享内存池
+#include <cstdio> // 包含 FILE
+#include <utility> // 包含 std::forward
 
 namespace memoryPool // 定义一个名为 memoryPool 的命名空间，用于组织相关的类和函数
 {
@@ -11,14 +21,298 @@ public:
     static void* allocate(size_t size) // 静态成员函数，用于分配指定大小的内存
     {
         // 调用 ThreadCache 类的单例实例的 allocate 方法来分配内存
-        return ThreadCache::getInstance()->allocate(size);
+        void* ptr = ThreadCache::getInstance()->allocate(size);
+        MEMORY_POOL_TRACE_EVENT(AllocTrace::OP_ALLOC, ptr, size);
+        return ptr;
     }
 
     static void deallocate(void* ptr, size_t size) // 静态成员函数，用于释放之前分配的内存
     {
+        MEMORY_POOL_TRACE_EVENT(AllocTrace::OP_FREE, ptr, size);
         // 调用 ThreadCache 类的单例实例的 deallocate 方法来释放内存
         ThreadCache::getInstance()->deallocate(ptr, size);
     }
+
+    // 批量分配 count 个大小为 size 的内存块，写入 out
+    // 返回值: 实际分配的个数，小于 count 表示内存不足
+    static size_t allocateBatch(size_t size, size_t count, void** out)
+    {
+        size_t filled = ThreadCache::getInstance()->allocateBatch(size, count, out);
+#ifdef MEMORY_POOL_TRACE
+        for (size_t i = 0; i < filled; ++i)
+        {
+            MEMORY_POOL_TRACE_EVENT(AllocTrace::OP_ALLOC, out[i], size);
+        }
+#endif
+        return filled;
+    }
+
+    // 批量释放 count 个大小为 size 的内存块
+    static void deallocateBatch(size_t size, size_t count, void** ptrs)
+    {
+#ifdef MEMORY_POOL_TRACE
+        for (size_t i = 0; i < count; ++i)
+        {
+            MEMORY_POOL_TRACE_EVENT(AllocTrace::OP_FREE, ptrs[i], size);
+        }
+#endif
+        ThreadCache::getInstance()->deallocateBatch(size, count, ptrs);
+    }
+
+    // 按指定对齐分配内存
+    // span 起始地址按页对齐，而同一大小类的内存块在 span 内紧密排列，
+    // 因此把大小向上取整到 alignment 的倍数后，内存块地址天然满足不超过一页的对齐要求。
+    static void* allocate(size_t size, size_t alignment)
+    {
+        if (alignment <= ALIGNMENT)
+        {
+            return allocate(size);
+        }
+
+        size_t alignedSize = alignUp(size, alignment);
+        if (alignment <= PageCache::PAGE_SIZE && alignedSize <= MAX_BYTES)
+        {
+            return allocate(alignedSize);
+        }
+
+        // 超大对齐或大对象交给系统分配，之后用 free 释放
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, alignment, alignedSize) != 0) return nullptr;
+        MEMORY_POOL_TRACE_EVENT(AllocTrace::OP_ALLOC, ptr, alignedSize);
+        return ptr;
+    }
+
+    // 释放按指定对齐分配的内存，size 与 alignment 必须与分配时一致
+    static void deallocate(void* ptr, size_t size, size_t alignment)
+    {
+        if (alignment <= ALIGNMENT)
+        {
+            deallocate(ptr, size);
+            return;
+        }
+
+        size_t alignedSize = alignUp(size, alignment);
+        if (alignment <= PageCache::PAGE_SIZE && alignedSize <= MAX_BYTES)
+        {
+            deallocate(ptr, alignedSize);
+        }
+        else
+        {
+            MEMORY_POOL_TRACE_EVENT(AllocTrace::OP_FREE, ptr, alignedSize);
+            free(ptr);
+        }
+    }
+
+    // 不带大小的释放：通过页表查询内存块大小，查不到说明来自系统分配
+    static void deallocate(void* ptr)
+    {
+        if (!ptr) return;
+
+        // 采样对象不在页表中，由采样分析器记录其大小
+        if (__builtin_expect(HeapProfiler::isSampled(ptr), 0))
+        {
+            deallocate(ptr, HeapProfiler::sampledObjectSize(ptr));
+            return;
+        }
+
+        size_t size = PageCache::getObjectSize(ptr);
+        if (size)
+        {
+            deallocate(ptr, size);
+        }
+        else
+        {
+            MEMORY_POOL_TRACE_EVENT(AllocTrace::OP_FREE, ptr, 0);
+            free(ptr);
+        }
+    }
+
+    // 编译期已知大小的分配：大小类别索引在编译期求出，线程本地弹出操作内联到调用处
+    template <size_t Size>
+    static void* allocate()
+    {
+        if constexpr (Size > MAX_BYTES)
+        {
+            return allocate(Size);
+        }
+        else
+        {
+            constexpr size_t index = SizeClass::getIndex(Size);
+            void* ptr = ThreadCache::getInstance()->allocateByIndex(index);
+            MEMORY_POOL_TRACE_EVENT(AllocTrace::OP_ALLOC, ptr, Size);
+            return ptr;
+        }
+    }
+
+    // 编译期已知大小的释放，Size 必须与分配时一致
+    template <size_t Size>
+    static void deallocate(void* ptr)
+    {
+        if constexpr (Size > MAX_BYTES)
+        {
+            deallocate(ptr, Size);
+        }
+        else
+        {
+            constexpr size_t index = SizeClass::getIndex(Size);
+            MEMORY_POOL_TRACE_EVENT(AllocTrace::OP_FREE, ptr, Size);
+            ThreadCache::getInstance()->deallocateByIndex(ptr, index);
+        }
+    }
+
+    // 在内存池中构造一个 T 对象
+    // sizeof(T) 总是 alignof(T) 的倍数，因此不超过一页的对齐要求天然满足（原理见 allocate(size, alignment)）
+    template <typename T, typename... Args>
+    static T* create(Args&&... args)
+    {
+        static_assert(alignof(T) <= PageCache::PAGE_SIZE, "alignment larger than a page is not supported");
+
+        void* memory = allocate<sizeof(T)>();
+        if (!memory) throw std::bad_alloc();
+
+        try
+        {
+            return new (memory) T(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            deallocate<sizeof(T)>(memory);
+            throw;
+        }
+    }
+
+    // 析构并释放由 create 构造的对象
+    template <typename T>
+    static void destroy(T* obj)
+    {
+        if (!obj) return;
+
+        obj->~T();
+        deallocate<sizeof(T)>(obj);
+    }
+
+    // 汇总三层缓存的统计，开销与大小类别数和线程数成正比，只应按需调用
+    static PoolStats getStats();
+
+    // 以可读格式输出统计
+    static void dumpStats(FILE* out);
+
+    // 把当前线程缓存的全部内存块归还，线程即将长时间空闲（不再进入分配慢速路径）时调用
+    static void releaseThreadCache()
+    {
+        ThreadCache::getInstance()->releaseAll();
+    }
+
+    // 为当前线程开启异步补充：本地链表变短时由后台线程从中心缓存预取下一批，
+    // 中心缓存的锁、页缓存分配和 mmap 不再出现在本线程的分配路径上。适合延迟敏感的线程
+    static void enableAsyncRefill()
+    {
+        ThreadCache::getInstance()->enableAsyncRefill();
+    }
+
+    // 关闭当前线程的异步补充
+    static void disableAsyncRefill()
+    {
+        ThreadCache::getInstance()->disableAsyncRefill();
+    }
+
+    // 设置线程缓存的衰减间隔（毫秒，默认 1000，0 表示关闭）
+    // 线程进入慢速路径时，若距上次衰减超过间隔，把每个大小类别在该间隔内一直未被用到的内存块归还
+    static void setThreadCacheDecay(uint64_t intervalMs)
+    {
+        ThreadCache::setDecayInterval(intervalMs);
+    }
+
+    // 为当前线程预留 count 个大小为 size 的内存块：线程缓存最多持有 64 个，并预先写入它们覆盖的页面，
+    // 其余在中心缓存中切分好。新线程在处理请求前调用，首批分配不再进入慢速路径，也不再缺页。
+    // 大对象不经过线程缓存，直接返回 true；内存不足时返回 false
+    static bool reserve(size_t size, size_t count);
+
+    // 按预热配置（见 PrewarmProfile）逐个大小类别调用 reserve，任一类别失败时返回 false
+    static bool prewarm(const PrewarmProfile& profile);
+
+    // 设置驻留内存的软、硬限制（字节，0 表示不限制，见 MemoryLimit）
+    // 超过软限制时主动归还缓存的内存；触及硬限制时先归还并调用压力回调，仍不足时分配返回 nullptr
+    static void setMemoryLimits(size_t softBytes, size_t hardBytes)
+    {
+        MemoryLimit::setLimits(softBytes, hardBytes);
+    }
+
+    // 设置内存压力回调（软压力和硬压力时调用），应用可在其中释放自己缓存的对象
+    static void setPressureCallback(PressureCallback callback, void* arg = nullptr)
+    {
+        MemoryLimit::setCallback(callback, arg);
+    }
+
+    // 立即把缓存的空闲内存归还操作系统，返回归还的字节数；其他线程的线程缓存在其下一次慢速路径中清空
+    static size_t releaseFreeMemory()
+    {
+        return MemoryLimit::releaseFreeMemory();
+    }
+
+    // 启动 / 停止监视 PSI 和 cgroup 内存文件的后台线程，检测到压力时按同样方式处理
+    static void startPressureWatcher(const PressureWatcherConfig& config = PressureWatcherConfig())
+    {
+        MemoryLimit::startWatcher(config);
+    }
+
+    static void stopPressureWatcher()
+    {
+        MemoryLimit::stopWatcher();
+    }
+
+    // 开启 NUMA 分片：每个节点一个页缓存和中心缓存，线程从所在节点取内存，新映射的内存绑定到该节点
+    // topology 为 nullptr 时使用系统拓扑；单节点机器上不开启并返回 false（见 Numa）
+    static bool enableNuma(const NumaTopology* topology = nullptr)
+    {
+        return Numa::enable(topology);
+    }
+
+    static void disableNuma()
+    {
+        Numa::disable();
+    }
+
+    // 打开或创建文件映射的持久化堆（见 PersistentHeap），文件为空时按 size 创建
+    // 重启后用同一路径打开，通过 root() 找回上次建立的数据结构；失败时返回 nullptr
+    static std::unique_ptr<PersistentHeap> openPersistent(const char* path,
+                                                          size_t size = PersistentHeap::DEFAULT_SIZE)
+    {
+        return PersistentHeap::open(path, size);
+    }
+
+    // 创建或映射多进程共享的内存池（见 SharedPool），name 为 POSIX 共享内存名（以 / 开头）
+    // 进程之间以 toOffset/fromOffset 转换的偏移传递消息；失败时返回 nullptr
+    static std::unique_ptr<SharedPool> createShared(const char* name, size_t size)
+    {
+        return SharedPool::create(name, size);
+    }
+
+    static std::unique_ptr<SharedPool> attachShared(const char* name)
+    {
+        return SharedPool::attach(name);
+    }
+
+    // 进入实时模式：映射 config.heapBytes 的固定堆并预先触发全部缺页（可选 mlock），
+    // 为 config.classes 预先切分中心缓存的 slab 并填充当前线程的线程缓存，之后页缓存不再向操作系统申请内存，
+    // 堆用尽时分配直接返回 nullptr 而不是增长。同时关闭线程缓存衰减，大对象改为从固定堆按页分配。
+    // 线程缓存命中时分配和释放既无锁也无系统调用；未命中时只在已驻留的内存中切分，仍会短暂持有中心缓存的锁。
+    // 返回 false 表示映射、锁定或预先填充失败，此时不进入实时模式
+    static bool enterRealtime(const RealtimeConfig& config);
+
+    // 其他实时线程开始工作前调用：为当前线程创建线程缓存、预先触发其缺页，并按 config.classes 填充
+    static bool prepareRealtimeThread(const RealtimeConfig& config);
+
+    // 退出实时模式：页缓存恢复增长，衰减间隔恢复原值，之后的大对象重新使用 malloc
+    static void exitRealtime();
+
+private:
+    static size_t alignUp(size_t size, size_t alignment)
+    {
+        // 0 大小的请求也需要返回一个独立的对齐地址
+        size = size ? size : 1;
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
 };
 
 } // namespace memoryPool
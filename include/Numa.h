@@ -0,0 +1,102 @@
+#pragma once
+#include "Common.h"
+#include <atomic>
+#include <mutex>
+
+namespace memoryPool
+{
+
+class PageCache;
+class CentralCache;
+
+// NUMA 拓扑来源
+// 默认使用系统拓扑；测试可以注入自己的实现，在单节点机器上模拟多个节点
+class NumaTopology
+{
+public:
+    virtual ~NumaTopology() = default;
+
+    // 节点数
+    virtual size_t nodeCount() const = 0;
+
+    // 调用线程当前运行的节点
+    virtual size_t currentNode() const = 0;
+
+    // 把 [addr, addr + bytes) 的物理页放到 node 上，在首次写入之前调用
+    virtual bool bind(void* addr, size_t bytes, size_t node) const = 0;
+};
+
+// 系统拓扑：节点数来自 /sys/devices/system/node/online，当前节点来自 getcpu，
+// 绑定使用 mbind(MPOL_PREFERRED)：节点内存耗尽时退回其他节点，而不是让缺页失败
+class SystemNumaTopology : public NumaTopology
+{
+public:
+    static const SystemNumaTopology& getInstance()
+    {
+        static SystemNumaTopology instance;
+        return instance;
+    }
+
+    size_t nodeCount() const override { return nodes_; }
+    size_t currentNode() const override;
+    bool bind(void* addr, size_t bytes, size_t node) const override;
+
+private:
+    SystemNumaTopology();
+
+    size_t nodes_;
+};
+
+// NUMA 分片
+// 开启后每个节点有自己的页缓存和中心缓存（节点 0 使用全局实例），线程缓存从所在节点的分片取内存块，
+// 分片的页缓存向操作系统申请的内存在清零之前绑定到该节点。线程在慢速路径中查询所在节点，迁移后改从新节点取。
+// 内存块无论由哪个节点的线程释放，都归还给切分它的 slab 所属的中心缓存（见 Span::central）。
+//
+// 约束：
+// - 分片创建后不再释放，其中的内存在关闭后仍照常分配和归还
+// - 内存限制（MemoryLimit）只作用于节点 0 的页缓存，实时模式的固定堆也只预留在节点 0；大对象来自 malloc，不分片
+class Numa
+{
+public:
+    static constexpr size_t MAX_NODES = 64;
+
+    // 开启：topology 为 nullptr 时使用系统拓扑，须在进程剩余时间内有效；节点数不超过 1 时不开启并返回 false
+    static bool enable(const NumaTopology* topology = nullptr);
+
+    // 关闭：线程缓存在下一次慢速路径中改回全局中心缓存
+    static void disable();
+
+    static bool enabled()
+    {
+        return enabled_.load(std::memory_order_acquire);
+    }
+
+    // 调用线程应当使用的中心缓存，未开启时为全局实例
+    static CentralCache* currentCentral();
+
+    // 已创建的分片数（至少为 1，节点 0 即全局实例）及各分片的缓存，用于统计和归还
+    static size_t shardCount()
+    {
+        return shards_.load(std::memory_order_acquire);
+    }
+
+    static PageCache& pageCache(size_t node);
+    static CentralCache& centralCache(size_t node);
+
+private:
+    static inline std::atomic<bool> enabled_{false};
+    static inline std::atomic<const NumaTopology*> topology_{nullptr};
+    // 当前拓扑的节点数
+    static inline std::atomic<size_t> nodes_{1};
+    // 已创建的分片数，只增不减
+    static inline std::atomic<size_t> shards_{1};
+
+    // 节点 1 及以后的分片，节点 0 使用全局实例
+    static inline PageCache* pageCaches_[MAX_NODES] = {};
+    static inline CentralCache* centralCaches_[MAX_NODES] = {};
+
+    // 串行化 enable / disable
+    static inline std::mutex mutex_;
+};
+
+} // namespace memoryPool
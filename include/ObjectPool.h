@@ -0,0 +1,41 @@
+#pragma once
+#include "MemoryPool.h"
+#include <utility>
+
+namespace memoryPool
+{
+
+// 类型化对象池
+// 仅包含头文件，T 的大小类别索引在编译期确定，分配/释放内联为线程本地自由链表的弹出/压入。
+// 所有 ObjectPool<T> 共享同一个内存池，不持有任何状态。
+template <typename T>
+class ObjectPool
+{
+public:
+    // 构造一个 T 对象
+    template <typename... Args>
+    static T* create(Args&&... args)
+    {
+        return MemoryPool::create<T>(std::forward<Args>(args)...);
+    }
+
+    // 析构并释放对象
+    static void destroy(T* obj)
+    {
+        MemoryPool::destroy(obj);
+    }
+
+    // 只分配未构造的内存，大小为 sizeof(T)
+    static void* allocate()
+    {
+        return MemoryPool::allocate<sizeof(T)>();
+    }
+
+    // 释放 allocate() 得到的内存
+    static void deallocate(void* ptr)
+    {
+        MemoryPool::deallocate<sizeof(T)>(ptr);
+    }
+};
+
+} // namespace memoryPool
@@ -0,0 +1,36 @@
+#pragma once
+#include "Common.h"
+
+namespace memoryPool
+{
+
+// 以偏移管理的页分配器
+// 状态本身保存在它所管理的映射中（持久化堆、共享内存池的头部），所有位置都是相对映射起点的偏移，
+// 因此映射到不同地址、或在进程重启后仍然有效。偏移 0 表示空（映射开头总是头部）。
+// 分配先在按地址有序的空闲页段链表中首次适配，再从未使用区域切分；释放时与相邻页段合并，
+// 紧邻未使用区域的页段直接并入。不是线程安全的，由调用者加锁。
+struct OffsetPages
+{
+    uint64_t top;      // 未使用区域的起点，之后的页从未分配过
+    uint64_t limit;    // 映射的总字节数
+    uint64_t freeRuns; // 空闲页段链表，节点保存在页段开头
+
+    // 初始化：[begin, limit) 为可分配区域
+    void init(uint64_t begin, uint64_t end)
+    {
+        top = begin;
+        limit = end;
+        freeRuns = 0;
+    }
+
+    // 分配 numPages 页，返回偏移，空间不足时返回 0
+    uint64_t allocate(char* base, size_t numPages);
+
+    // 归还 [offset, offset + numPages 页)
+    void free(char* base, uint64_t offset, size_t numPages);
+
+    // 从未使用区域切分出去的字节数（含空闲页段）
+    uint64_t carvedBytes(uint64_t begin) const { return top - begin; }
+};
+
+} // namespace memoryPool
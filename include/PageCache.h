@@ -1,16 +1,56 @@
 #pragma once
 #include "Common.h"
+#include "PageMap.h"
+#include "Stats.h"
+#include "MemoryLimit.h"
+#include <atomic>
 #include <map>
 #include <mutex>
+#include <vector>
 
 namespace memoryPool
 {
 
+class CentralCache;
+class NumaTopology;
+
+// Span 结构体：表示一段连续的页
+// 元数据本身通过 malloc 分配，见 SystemAllocated
+struct Span : SystemAllocated
+{
+    void*  pageAddr; // 内存块的起始地址
+    size_t numPages; // 内存块包含的页面数量
+    size_t objSize;  // 切分出的内存块大小，0 表示空闲或未切分
+    std::atomic<void*> owner{nullptr}; // 所属的 ThreadCache，用于跨线程释放时归还给所属线程
+    Span*  next;     // 指向下一个 Span 的指针，用于链表管理
+    bool   released = false; // 空闲期间已用 MADV_DONTNEED 归还给操作系统，再次分配时重新计入驻留
+    size_t shard = 0;        // 所属的页缓存分片，分割出的 span 沿用，释放时归还到该分片
+
+    // 以下字段由 CentralCache 在持有对应大小类别的锁时维护（span 作为 slab 使用期间）
+    Span*     prev = nullptr;       // CentralCache 中双向链表的前驱（后继复用 next）
+    size_t    totalBlocks = 0;      // 切分出的内存块总数
+    size_t    useCount = 0;         // 已交给线程缓存的内存块数
+    uint64_t* freeBitmap = nullptr; // 空闲位图，第 i 位为 1 表示第 i 个内存块空闲
+    size_t    searchHint = 0;       // 位图中第一个可能含空闲位的字
+    size_t    color = 0;            // 第一个内存块相对 pageAddr 的偏移（缓存着色）
+    int       listId = -1;          // 当前所在的 CentralCache 链表
+    CentralCache* central = nullptr; // 切分该 slab 的中心缓存，NUMA 分片下释放时据此归还
+};
+
+// 页缓存
+// 内部分为 SHARDS 个分片，每个分片有自己的空闲链表、映射段和锁，span 只在所属分片内分割与合并。
+// 切分 slab 的请求按大小类别选择分片（不同类别互不竞争），
+// 其余请求按当前 CPU 选择；所选分片没有合适的空闲 span 时依次尝试其他分片，都没有才向操作系统申请。
+// systemAlloc（mmap 与清零）不持有任何锁（中心缓存申请 slab 时也释放类别锁），页表读写无锁。
 class PageCache
 {
 public:
     // 定义页面大小为 4KB (4096 字节)，这是操作系统中常见的页面大小
-    static const size_t PAGE_SIZE = 4096;
+    static constexpr size_t PAGE_SIZE = 4096;
+    static constexpr size_t PAGE_SHIFT = 12;
+
+    // 分片数
+    static constexpr size_t SHARDS = 8;
 
     // 单例模式：获取 PageCache 的唯一实例
     static PageCache& getInstance()
@@ -20,37 +60,156 @@ public:
     }
 
     // 分配指定页数的内存块（span）
-    void* allocateSpan(size_t numPages);
+    // 参数 objSize: span 被切分成的内存块大小，0 表示不切分（供按指针查询大小使用）
+    void* allocateSpan(size_t numPages, size_t objSize = 0);
 
     // 释放之前分配的内存块（span）
     void deallocateSpan(void* ptr, size_t numPages);
 
+    // 汇总从操作系统映射 / 归还的字节数以及空闲 span 的字节数
+    void collectStats(PoolStats& stats);
+
+    // 预留一段固定的堆：一次映射 numPages 页并预先建立全部页表项（MAP_POPULATE），作为空闲 span 放入页缓存
+    // 参数 lockMemory: 是否用 mlock 锁定，防止被换出；锁定失败时撤销映射并返回 false
+    bool reserve(size_t numPages, bool lockMemory);
+
+    // 是否允许向操作系统申请新内存；关闭后空闲 span 不足时 allocateSpan 直接返回 nullptr
+    void setGrowthEnabled(bool enabled);
+
+    // 设置驻留字节数的软、硬限制（0 表示不限制，见 MemoryLimit）
+    // 分配使驻留字节数超过软限制时登记软压力；超过硬限制时返回 nullptr 并登记硬压力
+    void setLimits(size_t softBytes, size_t hardBytes);
+
+    // 是否有待处理的压力（线程缓存慢速路径中检查）
+    bool pressurePending() const
+    {
+        return pressure_.load(std::memory_order_relaxed) != MemoryPressure::NONE;
+    }
+
+    // 取出并清除待处理的压力
+    MemoryPressure takePressure()
+    {
+        return pressure_.exchange(MemoryPressure::NONE, std::memory_order_relaxed);
+    }
+
+    // 把全部空闲 span 以 MADV_DONTNEED 归还操作系统（保留映射，之后可直接复用）
+    // 先在锁内把 span 从空闲链表摘下，madvise 期间不持锁，完成后再放回；期间这些 span 不可分配，也不计入统计
+    // 实时模式（不允许增长）下不归还，避免重新缺页；返回本次归还的字节数
+    size_t releaseFreeSpans();
+
+    // 驻留字节数：映射的字节数减去已归还的字节数
+    size_t residentBytes();
+
+    // 设置本页缓存所属的 NUMA 节点：之后向操作系统申请的内存在清零前绑定到 node，topology 为 nullptr 时不绑定
+    void setNode(const NumaTopology* topology, size_t node);
+
+    // 为 [addr, addr + bytes) 所在的页预先建立可写的页表项，lockMemory 时同时锁定
+    // 用于实时模式下的元数据（线程缓存实例、中心缓存、页表根节点），之后首次写入不会缺页
+    static bool prefault(const void* addr, size_t bytes, bool lockMemory);
+
+    // 预先触发页表根节点的缺页，之后按任意指针查询都不会缺页
+    static bool prefaultPageMap(bool lockMemory)
+    {
+        return prefault(&pageMap(), sizeof(PageMap<Span>), lockMemory);
+    }
+
+    // 查询指针所在内存块的大小
+    // 无锁，可在任意线程调用；不属于内存池（或所在 span 空闲）时返回 0
+    static size_t getObjectSize(void* ptr);
+
+    // 查询指针所在 span 的所属者（获取该 span 的第一个 ThreadCache），无所属者时返回 nullptr
+    static void* getSpanOwner(void* ptr);
+
+    // 对以 start 开头、nullptr 结尾的内存块链表中涉及的每个 span：尚无所属者时把 owner 设为其所属者
+    static void claimSpanOwners(void* start, void* owner);
+
+    // 查询指针所在的 Span，无锁；不属于内存池时返回 nullptr
+    static Span* mapObjectToSpan(void* ptr)
+    {
+        return pageMap().get(pageIdOf(ptr));
+    }
+
 private:
-    // 私有构造函数，防止外部直接实例化，只能通过 getInstance 获取
+    // 私有构造函数，防止外部直接实例化，只能通过 getInstance 获取（Heap 为每个堆创建独立实例）
     PageCache() = default;
+    friend class Heap;
+    friend class Numa;
 
     // 向操作系统申请内存的私有方法
     void* systemAlloc(size_t numPages);
 
+    // 检查使 bytes 字节重新驻留是否超过限制；并发分配时按各自看到的计数判断，可能略微超出软、硬限制
+    // 返回值: false 表示超过硬限制，分配应当失败
+    bool admitResident(size_t bytes);
+
+    // 把从操作系统映射的全部内存归还，删除所有 span 元数据并清除页表登记
+    // 调用者保证不再有任何指向这些内存的访问（见 Heap::destroy）
+    void releaseAll();
+
 private:
-    // Span 结构体：表示一个内存块
-    struct Span
+    // 全局页表：页号 -> Span，所有 PageCache 共享
+    static PageMap<Span>& pageMap()
+    {
+        static PageMap<Span> map;
+        return map;
+    }
+
+    static size_t pageIdOf(void* ptr)
     {
-        void*  pageAddr; // 内存块的起始地址
-        size_t numPages; // 内存块包含的页面数量
-        Span*  next;     // 指向下一个 Span 的指针，用于链表管理
+        return reinterpret_cast<uintptr_t>(ptr) >> PAGE_SHIFT;
+    }
+
+    // 分片：空闲 Span 链表、映射段及保护它们的锁，按缓存行对齐避免相邻分片的锁互相干扰
+    struct alignas(64) Shard
+    {
+        // 空闲 Span 链表的容器，按页面数量组织
+        // key 是页面数，value 是对应页面数的空闲 Span 链表头指针
+        std::map<size_t, Span*, std::less<size_t>,
+                 SystemAllocator<std::pair<const size_t, Span*>>> freeSpans;
+
+        // 从操作系统映射的每一段内存（起始地址 -> 页数），用于判断相邻页是否属于本分片，releaseAll 按段解除映射
+        std::map<void*, size_t, std::less<void*>,
+                 SystemAllocator<std::pair<void* const, size_t>>> regions;
+
+        // 空闲页数，在锁内更新；其他分片回退查找时无锁读取，跳过没有足够空闲页的分片
+        std::atomic<size_t> freePages{0};
+
+        std::mutex mutex;
     };
 
-    // 空闲 Span 链表的容器，按页面数量组织
-    // key 是页面数，value 是对应页面数的空闲 Span 链表头指针
-    std::map<size_t, Span*> freeSpans_;
+    // 选择请求所在的分片
+    static size_t shardFor(size_t objSize);
+
+    // 从指定分片取出至少 numPages 页的空闲 span 并分割，没有合适的 span 时返回 nullptr
+    // rejected: 找到的 span 已归还给操作系统且重新驻留超过硬限制
+    void* allocateFromShard(size_t shardIndex, size_t numPages, size_t objSize, bool& rejected);
+
+    // 空闲链表的插入和移除，调用者持有分片的锁
+    static void pushFree(Shard& shard, Span* span);
+    static bool eraseFree(Shard& shard, Span* span);
+
+    // addr 是否位于分片映射的某一段内，调用者持有分片的锁
+    static bool ownsPage(const Shard& shard, void* addr);
+
+    Shard shards_[SHARDS];
+
+    // 从操作系统映射的字节数、已归还给操作系统的字节数
+    std::atomic<size_t> mappedBytes_{0};
+    std::atomic<size_t> releasedBytes_{0};
+
+    // 是否允许 systemAlloc（实时模式下关闭）
+    std::atomic<bool> growthEnabled_{true};
+
+    // 驻留字节数的软、硬限制，0 表示不限制
+    std::atomic<size_t> softLimit_{0};
+    std::atomic<size_t> hardLimit_{0};
 
-    // 已分配 Span 的映射，用于回收时查找
-    // key 是 Span 的起始地址，value 是对应的 Span 对象指针
-    std::map<void*, Span*> spanMap_;
+    // NUMA 分片的拓扑和节点，topology_ 为 nullptr 时不绑定
+    std::atomic<const NumaTopology*> topology_{nullptr};
+    std::atomic<size_t> node_{0};
 
-    // 互斥锁，用于保护 freeSpans_ 和 spanMap_ 的线程安全访问
-    std::mutex mutex_;
+    // 待处理的压力，由 allocateSpan 登记，由 MemoryLimit 在不持锁的位置取出处理
+    std::atomic<MemoryPressure> pressure_{MemoryPressure::NONE};
 };
 
 } // namespace memoryPool
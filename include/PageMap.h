@@ -0,0 +1,92 @@
+#pragma once
+#include "Common.h"
+#include <sys/mman.h> // 用于 mmap 分配叶子节点
+
+namespace memoryPool
+{
+
+// 页号到元数据的两级基数树
+// 覆盖 48 位虚拟地址空间（4KB 页 -> 36 位页号），根节点常驻，叶子节点按需通过 mmap 分配。
+// 读写均无锁：读操作可在任意线程调用；写操作可以并发，只要各写者登记的页范围互不重叠
+// （PageCache 的各分片只写自己持有的 span 所在的页）。
+template <typename T>
+class PageMap
+{
+public:
+    // 页号位数：48 位地址 - 12 位页内偏移
+    static constexpr size_t ID_BITS = 36;
+    static constexpr size_t LEAF_BITS = 18;
+    static constexpr size_t ROOT_BITS = ID_BITS - LEAF_BITS;
+    static constexpr size_t ROOT_LENGTH = size_t(1) << ROOT_BITS;
+    static constexpr size_t LEAF_LENGTH = size_t(1) << LEAF_BITS;
+
+    PageMap()
+    {
+        for (auto& leaf : root_)
+        {
+            leaf.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    // 查询页号对应的元数据，未登记的页返回 nullptr
+    T* get(size_t pageId) const
+    {
+        if ((pageId >> ID_BITS) != 0) return nullptr;
+
+        Leaf* leaf = root_[pageId >> LEAF_BITS].load(std::memory_order_acquire);
+        if (!leaf) return nullptr;
+        return leaf->values[pageId & (LEAF_LENGTH - 1)].load(std::memory_order_acquire);
+    }
+
+    // 登记 [pageId, pageId + numPages) 范围内的页，返回 false 表示叶子节点分配失败
+    bool setRange(size_t pageId, size_t numPages, T* value)
+    {
+        for (size_t i = 0; i < numPages; ++i)
+        {
+            size_t id = pageId + i;
+            if ((id >> ID_BITS) != 0) return false;
+
+            Leaf* leaf = ensureLeaf(id >> LEAF_BITS);
+            if (!leaf) return false;
+            leaf->values[id & (LEAF_LENGTH - 1)].store(value, std::memory_order_release);
+        }
+        return true;
+    }
+
+    bool set(size_t pageId, T* value)
+    {
+        return setRange(pageId, 1, value);
+    }
+
+private:
+    struct Leaf
+    {
+        std::atomic<T*> values[LEAF_LENGTH];
+    };
+
+    Leaf* ensureLeaf(size_t rootIndex)
+    {
+        Leaf* leaf = root_[rootIndex].load(std::memory_order_acquire);
+        if (leaf) return leaf;
+
+        // mmap 返回的内存已清零，等价于所有条目为 nullptr
+        void* memory = mmap(nullptr, sizeof(Leaf), PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) return nullptr;
+
+        // 两个写者可能同时为同一根节点条目分配叶子节点，以 CAS 发布，失败的一方释放自己的叶子节点
+        Leaf* fresh = new (memory) Leaf;
+        if (root_[rootIndex].compare_exchange_strong(leaf, fresh, std::memory_order_acq_rel,
+                                                     std::memory_order_acquire))
+        {
+            return fresh;
+        }
+        munmap(memory, sizeof(Leaf));
+        return leaf;
+    }
+
+private:
+    std::array<std::atomic<Leaf*>, ROOT_LENGTH> root_;
+};
+
+} // namespace memoryPool
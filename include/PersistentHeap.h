@@ -0,0 +1,107 @@
+#pragma once
+#include "Common.h"
+#include <memory>
+#include <mutex>
+
+namespace memoryPool
+{
+
+// 持久化堆
+// 把一个文件（或 memfd）以 MAP_SHARED 映射到固定的基地址，全部元数据（大小类别的自由链表、空闲页段链表、
+// 未使用区域的起点）都以相对映射起点的偏移保存在映射开头的头部中。进程重启后重新映射同一个文件，
+// 堆和在其中建立的数据结构（通过 setRoot 登记的根对象）原样可用，恢复的开销只有一次 mmap。
+// 映射地址必须与创建时相同，因为应用数据中保存的是绝对指针；基地址被占用时打开失败。
+//
+// 布局：
+// - 头部：魔数、版本、基地址、大小、根对象、各大小类别的自由链表头（与 MemoryPool 相同的 8 字节粒度）
+// - 其余按页管理：小对象（不超过 MAX_BYTES）每次切分一段页，内存块释放后只回到自己的自由链表；
+//   大对象按页分配，释放的页段按地址有序地挂在空闲页段链表上并与相邻页段合并
+//
+// 约束：
+// - 容量在创建时确定，用尽时分配返回 nullptr
+// - 同一时刻只能有一个打开的实例（flock 排他锁），实例内部用互斥锁保护，可被多个线程使用
+// - 进程崩溃不会丢失已写入的数据（MAP_SHARED 的修改已在内核页缓存中），但崩溃时正在进行的分配或释放
+//   可能使元数据不一致；wasCleanShutdown() 报告上次是否正常关闭。sync() 把修改写回存储设备
+class PersistentHeap
+{
+public:
+    // 默认基地址，位于 x86-64 用户地址空间中通常不会被占用的区域
+    static constexpr uintptr_t DEFAULT_BASE = 0x600000000000;
+    // MemoryPool::openPersistent 创建新堆时的默认容量；文件按需占用磁盘空间
+    static constexpr size_t DEFAULT_SIZE = size_t(1) << 30; // 1GB
+
+    // 打开或创建堆文件
+    // 文件为空时按 size 创建新堆（向上取整到页）；已有的堆忽略 size 和 base，映射到创建时的基地址
+    // 返回值: 文件无法打开、格式不符、已被其他实例打开或基地址被占用时返回 nullptr
+    static std::unique_ptr<PersistentHeap> open(const char* path, size_t size,
+                                                uintptr_t base = DEFAULT_BASE);
+
+    // 在已打开的文件描述符（例如 memfd，可跨 exec 继承）上打开，内部复制描述符，调用者保留原描述符
+    static std::unique_ptr<PersistentHeap> open(int fd, size_t size, uintptr_t base = DEFAULT_BASE);
+
+    // 创建基于 memfd 的新堆，数据保存在匿名内存文件中，通过 fd() 交给其他进程或在 exec 后重新打开
+    static std::unique_ptr<PersistentHeap> createMemfd(const char* name, size_t size,
+                                                       uintptr_t base = DEFAULT_BASE);
+
+    ~PersistentHeap();
+
+    PersistentHeap(const PersistentHeap&) = delete;
+    PersistentHeap& operator=(const PersistentHeap&) = delete;
+
+    // 分配内存块，堆已满时返回 nullptr
+    void* allocate(size_t size);
+
+    // 释放内存块，size 必须与分配时一致
+    void deallocate(void* ptr, size_t size);
+
+    // 根对象：重启后查找堆中数据结构的入口
+    void setRoot(void* root);
+    void* root() const;
+
+    // 把映射的修改同步写回文件
+    bool sync();
+
+    // 上次关闭是否正常完成（新建的堆为 true）
+    bool wasCleanShutdown() const { return cleanShutdown_; }
+
+    // 映射的基地址、总字节数，以及已分配出去的字节数（小对象按大小类别计算）
+    void* base() const { return base_; }
+    size_t capacity() const { return size_; }
+    size_t bytesAllocated() const;
+
+    // 堆使用的文件描述符（带 FD_CLOEXEC，需要跨 exec 传递时先复制为不带该标志的描述符）
+    int fd() const { return fd_; }
+
+private:
+    struct Header;
+
+    PersistentHeap(int fd, char* base, size_t size, bool cleanShutdown)
+        : fd_(fd), base_(base), size_(size), cleanShutdown_(cleanShutdown) {}
+
+    Header* header() const { return reinterpret_cast<Header*>(base_); }
+
+    // 偏移与地址的转换，偏移 0 表示空
+    void* at(uint64_t offset) const { return offset ? base_ + offset : nullptr; }
+    uint64_t offsetOf(const void* ptr) const
+    {
+        return ptr ? static_cast<const char*>(ptr) - base_ : 0;
+    }
+
+    // 为大小类别切分一段页，串入自由链表
+    bool refill(size_t index);
+
+    // 大对象的页数、小对象每次切分的页数
+    static size_t pagesFor(size_t size);
+    static size_t slabPagesFor(size_t size);
+
+private:
+    int    fd_;
+    char*  base_;
+    size_t size_;
+    bool   cleanShutdown_;
+
+    // 保护头部和所有链表
+    mutable std::mutex mutex_;
+};
+
+} // namespace memoryPool
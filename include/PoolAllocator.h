@@ -0,0 +1,78 @@
+#pragma once
+#include "MemoryPool.h"
+#include <limits>
+#include <memory_resource>
+#include <new>
+
+namespace memoryPool
+{
+
+// 标准库分配器适配器
+// 满足 Allocator 要求，容器释放时已知 n * sizeof(T)，因此始终走带大小的快速路径。
+// 无状态：任意两个实例可以互相释放对方分配的内存。
+template <typename T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n)
+    {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+
+        void* ptr = MemoryPool::allocate(n * sizeof(T), alignof(T));
+        if (!ptr) throw std::bad_alloc();
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept
+    {
+        MemoryPool::deallocate(ptr, n * sizeof(T), alignof(T));
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+};
+
+// std::pmr 内存资源适配器，供 std::pmr 容器使用
+// 所有实例共享同一个内存池，因此彼此相等
+class PoolMemoryResource : public std::pmr::memory_resource
+{
+public:
+    // 获取进程内共享的实例
+    static PoolMemoryResource* getInstance()
+    {
+        static PoolMemoryResource instance;
+        return &instance;
+    }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        void* ptr = MemoryPool::allocate(bytes, alignment);
+        if (!ptr) throw std::bad_alloc();
+        return ptr;
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+    {
+        MemoryPool::deallocate(ptr, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return dynamic_cast<const PoolMemoryResource*>(&other) != nullptr;
+    }
+};
+
+} // namespace memoryPool
@@ -0,0 +1,37 @@
+#pragma once
+#include "Common.h"
+#include "Stats.h"
+#include <cstdio>
+#include <vector>
+
+namespace memoryPool
+{
+
+// 为一个大小类别预留的内存块
+struct ClassReserve
+{
+    size_t size;  // 内存块大小
+    size_t count; // 每个线程预留的内存块数：线程缓存最多持有 PrewarmProfile::MAX_THREAD_BLOCKS 个，其余切分好留在中心缓存
+};
+
+// 预热配置：新线程开始处理请求前，按配置为各大小类别填充线程缓存（见 MemoryPool::prewarm）
+// 可以由上一次运行的统计生成，保存到文本文件，下次部署时读回
+struct PrewarmProfile
+{
+    // 线程缓存每个大小类别最多持有的内存块数，超过时释放会把大部分归还中心缓存
+    static constexpr size_t MAX_THREAD_BLOCKS = 64;
+
+    std::vector<ClassReserve> classes;
+
+    // 由统计生成：取分配次数最多的 maxClasses 个大小类别，
+    // 最频繁的类别预留 MAX_THREAD_BLOCKS 个，其余按分配次数的比例递减，至少 1 个
+    static PrewarmProfile fromStats(const PoolStats& stats, size_t maxClasses = 32);
+
+    // 以文本保存，每行一个大小类别："<size> <count>"，以 # 开头的行为注释
+    bool save(FILE* out) const;
+
+    // 读回 save 保存的配置，无法解析的行被忽略
+    static PrewarmProfile load(FILE* in);
+};
+
+} // namespace memoryPool
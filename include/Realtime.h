@@ -0,0 +1,22 @@
+#pragma once
+#include "Common.h"
+#include "Prewarm.h"
+#include <vector>
+
+namespace memoryPool
+{
+
+// 实时模式配置（见 MemoryPool::enterRealtime）
+struct RealtimeConfig
+{
+    // 启动时一次映射并预先触发缺页的堆大小（字节），之后的全部 span 都从这里切分
+    size_t heapBytes = 64 * 1024 * 1024;
+
+    // 是否用 mlock 锁定预留的堆和元数据，防止被换出（需要足够的 RLIMIT_MEMLOCK）
+    bool lockMemory = false;
+
+    // 每个实时线程预先填充的大小类别（见 MemoryPool::reserve）
+    std::vector<ClassReserve> classes;
+};
+
+} // namespace memoryPool
@@ -0,0 +1,126 @@
+#pragma once
+#include "Common.h"
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+
+namespace memoryPool
+{
+
+// 共享内存池
+// 整个池位于一个 POSIX 共享内存段中，多个进程各自映射（地址可以不同），在其中分配的消息可以直接以偏移
+// 交给其他进程，由对方原地读取和释放，不需要复制。
+//
+// 分层与内存池相同，但中心层和页层的状态都保存在共享内存段的头部中，且全部链接都是相对段起点的偏移：
+// - 线程缓存：每个进程的每个线程一个（通过本进程实例的 pthread key 查找），保存在进程私有内存中，无锁
+// - 中心层：每个大小类别一个无锁栈（带版本号的偏移，避免 ABA），多个进程的线程直接以 CAS 存取
+// - 页层：按页分配和合并（见 OffsetPages），由进程间共享的健壮互斥锁保护，持有锁的进程退出后可被其他进程接管
+//
+// 约束：
+// - 释放时 size 必须与分配时一致，可以由任意进程的任意线程释放
+// - 线程缓存中的内存块只属于本进程；进程异常退出时其线程缓存中的内存块不会被回收
+// - fork 之后子进程不能使用继承来的实例（其线程缓存是父进程的副本），须通过 attach 重新打开
+// - 容量在创建时确定，用尽时分配返回 nullptr；段大小不超过 1TB（偏移占 40 位）
+class SharedPool
+{
+public:
+    // 创建新的共享内存段（名字已存在时失败），size 向上取整到页
+    static std::unique_ptr<SharedPool> create(const char* name, size_t size);
+
+    // 映射已有的共享内存段，段不存在或尚未初始化完成时返回 nullptr
+    static std::unique_ptr<SharedPool> attach(const char* name);
+
+    // 删除共享内存段的名字，已映射的进程不受影响
+    static bool unlink(const char* name);
+
+    // 归还本进程所有线程缓存中的内存块并解除映射；调用时不能有线程正在使用本实例
+    ~SharedPool();
+
+    SharedPool(const SharedPool&) = delete;
+    SharedPool& operator=(const SharedPool&) = delete;
+
+    // 分配内存块，共享内存段用尽时返回 nullptr
+    void* allocate(size_t size);
+
+    // 释放内存块，size 必须与分配时一致
+    void deallocate(void* ptr, size_t size);
+
+    // 指针与偏移的转换：偏移在所有映射了同一段的进程中都有效
+    uint64_t toOffset(const void* ptr) const
+    {
+        return static_cast<const char*>(ptr) - base_;
+    }
+
+    template <typename T = void>
+    T* fromOffset(uint64_t offset) const
+    {
+        return reinterpret_cast<T*>(base_ + offset);
+    }
+
+    // 把当前线程缓存的内存块全部归还中心层，线程即将长时间空闲时调用
+    void releaseThreadCache();
+
+    // 共享内存段的大小、页层从未使用区域切分出去的字节数
+    size_t capacity() const { return size_; }
+    size_t bytesCarved() const;
+
+private:
+    struct Header;
+    struct LocalCache;
+
+    SharedPool(int fd, char* base, size_t size);
+
+    Header* header() const { return reinterpret_cast<Header*>(base_); }
+
+    // 当前线程在本实例上的线程缓存，第一次使用时创建
+    LocalCache* localCache()
+    {
+        void* cache = pthread_getspecific(key_);
+        if (__builtin_expect(cache != nullptr, 1)) return static_cast<LocalCache*>(cache);
+        return createLocalCache();
+    }
+
+    LocalCache* createLocalCache();
+
+    // 线程退出时调用：归还线程缓存并释放它
+    static void destroyLocalCache(void* cache);
+
+    // 把线程缓存中某个大小类别的前 count 个内存块归还中心层
+    void flush(LocalCache* cache, size_t index, size_t count);
+
+    // 归还线程缓存中的全部内存块
+    void flushAll(LocalCache* cache);
+
+    // 线程缓存未命中：从中心层取一批，中心层为空时从页层切分新的页段
+    uint64_t fetch(LocalCache* cache, size_t index);
+
+    // 中心层的无锁栈操作
+    uint64_t popCentral(size_t index);
+    void pushCentral(size_t index, uint64_t first, uint64_t last);
+
+    // 页层：加锁分配和归还页段
+    uint64_t allocatePages(size_t numPages);
+    void freePages(uint64_t offset, size_t numPages);
+
+    // 内存块中保存的下一个节点的偏移
+    uint64_t& link(uint64_t offset) const
+    {
+        return *reinterpret_cast<uint64_t*>(base_ + offset);
+    }
+
+    static size_t pagesFor(size_t size);
+
+private:
+    int    fd_;
+    char*  base_;
+    size_t size_;
+
+    // 查找当前线程在本实例上的线程缓存
+    pthread_key_t key_;
+
+    // 保护本进程的线程缓存链表
+    std::mutex mutex_;
+    LocalCache* caches_ = nullptr;
+};
+
+} // namespace memoryPool
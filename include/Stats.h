@@ -0,0 +1,45 @@
+#pragma once
+#include "Common.h"
+#include <vector>
+
+namespace memoryPool
+{
+
+// 单个大小类别的统计
+struct ClassStats
+{
+    size_t size = 0;                  // 内存块大小
+    size_t allocs = 0;                // 累计分配次数
+    size_t frees = 0;                 // 累计释放次数
+    size_t centralFreeBytes = 0;      // 中心缓存 slab 中的空闲字节数
+    size_t threadCacheBytes = 0;      // 各线程缓存自由链表中的字节数
+    size_t internalFragmentation = 0; // 存活内存块中因向上取整浪费的字节数（估算）
+};
+
+// 内存池整体统计，由 MemoryPool::getStats() 按需汇总
+// 线程缓存的计数由各线程在本地维护，汇总时不加锁读取，因此是近似的快照
+struct PoolStats
+{
+    size_t mappedBytes = 0;           // 从操作系统映射的字节数
+    size_t residentBytes = 0;         // 仍驻留的字节数（映射减去已归还给操作系统的部分）
+    size_t releasedBytes = 0;         // 已归还给操作系统的字节数
+    size_t pageCacheFreeBytes = 0;    // PageCache 空闲 span 的字节数
+    size_t centralCacheBytes = 0;     // CentralCache 中的空闲字节数
+    size_t threadCacheBytes = 0;      // 所有线程缓存中的空闲字节数
+    size_t liveBytes = 0;             // 已分配给用户、尚未释放的字节数（按大小类别计）
+    size_t internalFragmentation = 0; // 所有大小类别的内部碎片之和
+    size_t largeAllocs = 0;           // 超过 MAX_BYTES、直接交给系统的分配次数
+    size_t largeFrees = 0;            // 超过 MAX_BYTES 的释放次数
+    size_t threadCaches = 0;          // 已创建的线程缓存实例数
+
+    // 有过分配或仍持有空闲内存的大小类别，按大小升序排列
+    std::vector<ClassStats, SystemAllocator<ClassStats>> classes;
+
+    // 汇总前：按大小类别索引展开 classes，各层直接累加到对应类别
+    void expandClasses();
+
+    // 汇总后：计算总量，并去掉没有任何活动的大小类别
+    void compactClasses();
+};
+
+} // namespace memoryPool
@@ -1,10 +1,21 @@
 #pragma once
 #include "Common.h"
+#include "Stats.h"
+#include "HeapProfiler.h"
+#include "Instrument.h"
+#include "AsyncRefill.h"
+#include "Numa.h"
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
 
 // 定义memoryPool命名空间，用于封装内存池相关的类和功能
 namespace memoryPool 
 {
 
+class CentralCache;
+class Heap;
+
 // 线程本地缓存类
 // ThreadCache为每个线程提供一个本地内存缓存，用于快速分配和释放小块内存，
 // 通过减少线程间竞争提高内存分配效率。
@@ -12,28 +23,261 @@ class ThreadCache
 {
 public:
     // 获取ThreadCache的单例实例
-    // 使用thread_local关键字确保每个线程拥有独立的ThreadCache实例，
-    // 静态局部变量保证线程安全的初始化。
+    // 每个线程只保存一个指向实例的指针，存放在 initial-exec 模型的 TLS 中：
+    // 指针是平凡初始化的，访问时没有 thread_local 初始化守卫，也不会调用 __tls_get_addr；
+    // 实例本身在线程第一次使用时才创建（见 createInstance）。
     static ThreadCache* getInstance()
     {
-        static thread_local ThreadCache instance;
-        return &instance;
+        ThreadCache* instance = tlsInstance_;
+        if (__builtin_expect(instance != nullptr, 1)) return instance;
+        return createInstance();
     }
 
-    // 分配指定大小的内存块
+    // 分配指定大小的内存块（内联快速路径）
     // 参数 size: 请求的内存块大小（以字节为单位）
     // 返回值: 指向分配的内存块的指针
-    void* allocate(size_t size);
+    void* allocate(size_t size)
+    {
+        // 处理0大小的分配请求
+        if (size == 0)
+        {
+            size = ALIGNMENT; // 至少分配一个对齐大小
+        }
+
+        if (__builtin_expect(size > MAX_BYTES, 0))
+        {
+            // 大对象直接从系统分配
+            largeAllocCount_++;
+            if (__builtin_expect(sampleCountdown(size), 0))
+            {
+                if (void* ptr = sampleAllocation(size)) return ptr;
+            }
+            // 实时模式下从预留的堆按页分配，不经过 malloc
+            if (__builtin_expect(fixedHeap_.load(std::memory_order_relaxed), 0)) return allocateLarge(size);
+            return malloc(size);
+        }
 
-    // 释放指定的内存块
+        size_t index = SizeClass::getIndex(size);
+        wastedBytes_[index] += (index + 1) * ALIGNMENT - size;
+        return allocateByIndex(index);
+    }
+
+    // 释放指定的内存块（内联快速路径）
     // 参数 ptr: 要释放的内存块的起始地址
     // 参数 size: 内存块的大小（以字节为单位）
-    void deallocate(void* ptr, size_t size);
+    void deallocate(void* ptr, size_t size)
+    {
+        if (__builtin_expect(size > MAX_BYTES, 0))
+        {
+            largeFreeCount_++;
+            if (__builtin_expect(HeapProfiler::isSampled(ptr), 0))
+            {
+                HeapProfiler::deallocateSampled(ptr);
+                return;
+            }
+            freeLarge(ptr);
+            return;
+        }
+
+        deallocateByIndex(ptr, SizeClass::getIndex(size));
+    }
+
+    // 按大小类别索引分配内存块（内联快速路径）
+    // 调用者在编译期已知索引时（见 MemoryPool::allocate<N>()），可省去大小计算和函数调用
+    // 参数 index: 自由链表的索引，必须小于 FREE_LIST_SIZE
+    void* allocateByIndex(size_t index)
+    {
+        // 采样倒计数耗尽时进入慢速路径，由采样分析器在独立区间中分配
+        if (__builtin_expect(sampleCountdown((index + 1) * ALIGNMENT), 0))
+        {
+            if (void* ptr = sampleAllocation((index + 1) * ALIGNMENT))
+            {
+                allocCount_[index]++;
+                return ptr;
+            }
+        }
+
+        // 本地自由链表非空时直接弹出链表头
+        MEMORY_POOL_PROBE_START(probeStart);
+        if (void* ptr = freeList_[index]; __builtin_expect(ptr != nullptr, 1))
+        {
+            freeList_[index] = *reinterpret_cast<void**>(ptr);
+            size_t remaining = --freeListSize_[index];
+            if (remaining < lowWater_[index]) lowWater_[index] = remaining;
+            allocCount_[index]++;
+            if (__builtin_expect(refill_ != nullptr, 0) && remaining < ASYNC_REFILL_MARK)
+            {
+                requestRefill(index);
+            }
+            MEMORY_POOL_PROBE_END(THREAD_CACHE_ALLOC, probeStart);
+            return ptr;
+        }
+
+        // 本地自由链表为空，从中心缓存批量获取
+        return fetchFromCentralCache(index);
+    }
+
+    // 按大小类别索引释放内存块（内联快速路径）
+    // 参数 ptr: 要释放的内存块，必须属于 index 对应的大小类别
+    void deallocateByIndex(void* ptr, size_t index)
+    {
+        // 采样对象不属于任何 span，交还给采样分析器
+        if (__builtin_expect(HeapProfiler::isSampled(ptr), 0))
+        {
+            freeCount_[index]++;
+            HeapProfiler::deallocateSampled(ptr);
+            return;
+        }
+
+        // 插入到线程本地自由链表头部
+        MEMORY_POOL_PROBE_START(probeStart);
+        void* head = freeList_[index];
+        if (__builtin_expect(head == nullptr, 0)) markActive(index);
+        *reinterpret_cast<void**>(ptr) = head;
+        freeList_[index] = ptr;
+        freeListSize_[index]++;
+        freeCount_[index]++;
+
+        // 本地内存块过多时归还一部分给中心缓存
+        if (__builtin_expect(shouldReturnToCentralCache(index), 0))
+        {
+            returnToCentralCache(freeList_[index], (index + 1) * ALIGNMENT);
+            return;
+        }
+        MEMORY_POOL_PROBE_END(THREAD_CACHE_FREE, probeStart);
+    }
+
+    // 批量分配 count 个大小为 size 的内存块，写入 out
+    // 返回值: 实际分配的个数，小于 count 表示内存不足
+    size_t allocateBatch(size_t size, size_t count, void** out);
+
+    // 批量释放 count 个大小为 size 的内存块
+    void deallocateBatch(size_t size, size_t count, void** ptrs);
+
+    // 把当前线程缓存的全部内存块归还（属于其他线程的送回所属线程），供即将长时间空闲的线程调用
+    void releaseAll();
+
+    // 为当前线程开启/关闭异步补充（见 AsyncRefill）
+    void enableAsyncRefill();
+    void disableAsyncRefill();
+
+    // 设置线程缓存衰减的间隔（毫秒），0 表示关闭；对所有线程生效
+    static void setDecayInterval(uint64_t intervalMs)
+    {
+        decayIntervalNs_.store(intervalMs * 1000000, std::memory_order_relaxed);
+    }
+
+    // 当前的衰减间隔（毫秒）
+    static uint64_t decayInterval()
+    {
+        return decayIntervalNs_.load(std::memory_order_relaxed) / 1000000;
+    }
+
+    // 为 size 所在大小类别预先填充本地链表，最多 RETURN_THRESHOLD 个，并写入内存块覆盖的页；
+    // 中心缓存内存不足时返回 false
+    bool prefill(size_t size, size_t count);
+
+    // 为本实例预先建立页表项（lockMemory 时同时锁定），之后首次访问任何大小类别的链表头和计数都不会缺页
+    bool prefault(bool lockMemory);
+
+    // 大对象是否从页缓存按页分配（实时模式），关闭后已分配的大对象仍可正常释放
+    static void setFixedHeap(bool enabled)
+    {
+        fixedHeap_.store(enabled, std::memory_order_relaxed);
+    }
+
+    // 请求全部线程缓存清空：当前线程立即归还，其他线程在各自的下一次慢速路径中归还（内存压力下调用）
+    static void flushAllThreads();
+
+    // 汇总所有线程缓存实例（包括已退出线程留下的实例）的统计
+    // stats.classes 须已按大小类别索引展开为 FREE_LIST_SIZE 项
+    static void collectStats(PoolStats& stats);
 
 private:
     // 私有默认构造函数
     // 防止外部直接实例化ThreadCache，只能通过getInstance()获取实例
     ThreadCache() = default;
+    friend class Heap;
+
+    // 为独立堆创建实例：从 central 取内存，不登记到全局实例链表，也不注册线程退出清理（由 Heap 管理）
+    static ThreadCache* createForHeap(CentralCache& central);
+
+    // 汇总从 first 开始、经 nextInstance_ 相连的实例，调用者保证链表不被并发修改
+    static void collectStats(PoolStats& stats, ThreadCache* first);
+
+    // 丢弃所有自由链表而不访问其中的内存块，用于其内存已被整体释放的堆（见 Heap::destroy）
+    void discardAll();
+
+    // 慢速路径：为当前线程创建实例，并注册线程退出时的清理函数
+    static ThreadCache* createInstance();
+
+    // 线程退出时调用：把所有自由链表归还给中心缓存，实例留待新线程复用
+    // 实例不会被释放，因为其他线程可能仍持有它作为 span 的所属者并向其远程释放链表压入内存块
+    static void destroyInstance(void* instance);
+
+    // 标记大小类别的本地链表非空，衰减时只遍历被标记的类别
+    void markActive(size_t index)
+    {
+        activeClasses_[index / 64] |= uint64_t(1) << (index % 64);
+    }
+
+    // 慢速路径调用：距上次衰减超过间隔时执行一次衰减
+    void maybeScavenge();
+
+    // 慢速路径调用：响应清空请求，处理页缓存登记的内存压力（只对全局实例）
+    void checkPressure();
+
+    // 衰减：每个大小类别在上个间隔内从未被用到的部分（低水位）归还给中心缓存
+    void scavenge();
+
+    // 从本地链表尾部（最久未用的一端）取出 count 个内存块归还
+    void releaseColdBlocks(size_t index, size_t count);
+
+    // 从页缓存按页分配大对象，span 的 objSize 记为整页大小（大于 MAX_BYTES），释放时据此识别
+    static void* allocateLarge(size_t size);
+
+    // 释放大对象：按页分配的交还页缓存，其余来自 malloc
+    static void freeLarge(void* ptr);
+
+    // 本地链表低于半个批量且该类别没有在途请求时，投递一个补充请求
+    void requestRefill(size_t index);
+
+    // 取出信箱中已送达的批量，接到各自的本地链表
+    void collectRefills();
+
+    // 扣减采样倒计数，返回 true 表示本次分配应当被采样
+    bool sampleCountdown(size_t size)
+    {
+        bytesUntilSample_ -= static_cast<ptrdiff_t>(size);
+        return bytesUntilSample_ < 0;
+    }
+
+    // 采样慢速路径：重置倒计数，采样分析器开启时在采样区间中分配
+    // 返回值: 采样对象，未开启或采样区间已满时返回 nullptr（调用者走普通路径）
+    void* sampleAllocation(size_t size);
+
+    // 其他线程调用：把一条属于本实例所拥有 span、共 count 个内存块的链表 [head, tail] 压入远程释放链表
+    void pushRemoteFrees(void* head, void* tail, size_t count);
+
+    // 所属线程调用：取出远程释放链表中的全部内存块，放回各自大小类别的本地自由链表
+    void drainRemoteFrees();
+
+    // 其他线程调用：取出 owner 远程释放链表中积压的全部内存块，归还给各自的中心缓存
+    // 所属线程空闲（不再未命中）时远程释放链表不会被取出，由此避免内存块一直滞留
+    static void reclaimRemoteFrees(ThreadCache* owner);
+
+    // 把一条同一大小类别、共 count 个内存块的链表归还给各自 slab 所属的中心缓存（NUMA 分片下可能不止一个）
+    void returnToCentral(void* start, size_t count, size_t index);
+
+    // 全局实例按所在的 NUMA 节点选择中心缓存（未开启时为全局实例），独立堆的实例不变
+    void selectCentral()
+    {
+        if (!heap_) central_ = Numa::currentCentral();
+    }
+
+    // 把一条同一大小类别的内存块链表按 span 所属者分流：
+    // 属于其他存活线程的压入其远程释放链表（积压超过 REMOTE_FREE_LIMIT 时改为归还），其余归还给中心缓存
+    void returnToOwners(void* start, size_t index);
 
     // 从中心缓存获取内存块
     // 参数 index: 自由链表的索引，表示请求的内存块大小类别
@@ -53,9 +297,66 @@ private:
     // 判断是否需要将内存块归还给中心缓存
     // 参数 index: 自由链表的索引，表示内存块大小类别
     // 返回值: true表示需要归还，false表示不需要
-    bool shouldReturnToCentralCache(size_t index);
+    bool shouldReturnToCentralCache(size_t index)
+    {
+        // 设定阈值：当自由链表中的内存块超过一定数量时归还
+        return freeListSize_[index] > RETURN_THRESHOLD;
+    }
+
+private:
+    // 线程本地自由链表的容量阈值（内存块个数）
+    static constexpr size_t RETURN_THRESHOLD = 64;
+
+    // 远程释放链表积压的上限（内存块个数），超过后其他线程不再压入，而是把积压的内存块归还给中心缓存
+    static constexpr size_t REMOTE_FREE_LIMIT = 4 * RETURN_THRESHOLD;
+
+    // 异步补充的触发上限：本地链表短于此值时才检查是否需要补充（实际阈值为半个批量）
+    static constexpr size_t ASYNC_REFILL_MARK = 32;
+
+    // 默认衰减间隔
+    static constexpr uint64_t DEFAULT_DECAY_INTERVAL_NS = 1000000000; // 1 秒
 
 private:
+    // 当前线程的实例指针
+    __attribute__((tls_model("initial-exec")))
+    static inline thread_local ThreadCache* tlsInstance_ = nullptr;
+
+    // 衰减间隔（纳秒），0 表示关闭
+    static inline std::atomic<uint64_t> decayIntervalNs_{DEFAULT_DECAY_INTERVAL_NS};
+
+    // 大对象是否从页缓存分配（见 setFixedHeap）
+    static inline std::atomic<bool> fixedHeap_{false};
+
+    // flushAllThreads 的请求计数，各实例与自己已响应的计数比较
+    static inline std::atomic<uint64_t> flushRequests_{0};
+
+    // 已退出线程留下的实例，供新线程复用
+    static std::mutex recycleMutex_;
+    static ThreadCache* recycled_;
+
+    // 所有创建过的实例（实例从不释放），供统计汇总遍历
+    static ThreadCache* allInstances_;
+
+    // 提供内存块的中心缓存：全局实例或所属堆的实例
+    CentralCache* central_;
+    // 所属的独立堆，全局实例为 nullptr
+    Heap* heap_;
+
+    // 复用链表中的下一个实例
+    ThreadCache* nextRecycled_;
+
+    // 全部实例链表中的下一个实例
+    ThreadCache* nextInstance_;
+
+    // 所属线程是否存活，已退出线程的实例不再接收远程释放
+    std::atomic<bool> alive_;
+
+    // 远程释放链表（多生产者单消费者）
+    // 其他线程释放属于本实例所拥有 span 的内存块时批量压入，由所属线程在未命中时一次取出
+    std::atomic<void*> remoteFree_;
+    // 远程释放链表中的内存块个数（近似值，压入后才累加）
+    std::atomic<size_t> remoteCount_;
+
     // 自由链表数组
     // freeList_存储不同大小类别的内存块的自由链表，每个元素是一个链表头指针，
     // FREE_LIST_SIZE定义了支持的内存块大小类别的数量。
@@ -64,6 +365,36 @@ private:
     // 自由链表大小统计数组
     // freeListSize_记录每个自由链表中当前内存块的数量，用于管理内存分配和归还策略。
     std::array<size_t, FREE_LIST_SIZE> freeListSize_; 
+
+    // 异步补充信箱，未开启时为 nullptr
+    RefillMailbox* refill_;
+    // 曾经开启过时创建的信箱，随实例复用
+    RefillMailbox* refillMailbox_;
+
+    // 上次衰减以来每个大小类别本地链表长度的最小值；这部分内存块在整个间隔内都没有被用到
+    std::array<size_t, FREE_LIST_SIZE> lowWater_;
+
+    // 本地链表可能非空的大小类别位图
+    std::array<uint64_t, FREE_LIST_SIZE / 64> activeClasses_;
+
+    // 上次衰减的时间（steady_clock 纳秒）
+    uint64_t lastScavenge_;
+
+    // 已响应的清空请求计数
+    uint64_t flushSeen_;
+
+    // 统计计数，只由所属线程写入，汇总时不加锁读取
+    // 实例在线程退出后被复用，计数随实例累积，因此所有实例之和覆盖了全部线程
+    std::array<size_t, FREE_LIST_SIZE> allocCount_;  // 每个大小类别的分配次数
+    std::array<size_t, FREE_LIST_SIZE> freeCount_;   // 每个大小类别的释放次数
+    std::array<size_t, FREE_LIST_SIZE> wastedBytes_; // 分配时向上取整浪费的累计字节数
+    size_t largeAllocCount_;
+    size_t largeFreeCount_;
+
+    // 距离下一次采样还需分配的字节数，新实例为 0，第一次分配即进入采样慢速路径完成初始化
+    ptrdiff_t bytesUntilSample_;
+    // 采样间隔的随机数状态
+    uint64_t sampleRng_;
 };
 
 } // namespace memoryPool
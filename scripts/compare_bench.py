@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""对比两次 benchmark 的 JSON 结果。
+
+用法: compare_bench.py base.json new.json [--threshold 5]
+
+按 (负载, 分配器, 线程数) 对齐两次运行，输出吞吐量、p99 延迟和峰值 RSS 的变化百分比。
+吞吐量下降或 p99 / 峰值 RSS 上升超过阈值（百分比）的行标记为 REGRESSION，存在回退时退出码为 1。
+"""
+
+import argparse
+import json
+import sys
+
+# 指标名, 列标题, 越大越好
+METRICS = [
+    ("ops_per_sec", "ops/s", True),
+    ("p99_ns", "p99 ns", False),
+    ("peak_rss_kb", "peak RSS KB", False),
+]
+
+
+def load(path):
+    with open(path) as f:
+        doc = json.load(f)
+    return {(r["workload"], r["allocator"], r["threads"]): r for r in doc["results"]}
+
+
+def change(base, new):
+    if base == 0:
+        return 0.0
+    return (new - base) * 100.0 / base
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("base")
+    parser.add_argument("new")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="regression threshold in percent (default 5)")
+    args = parser.parse_args()
+
+    base = load(args.base)
+    new = load(args.new)
+
+    header = f"{'workload':<14}{'alloc':<8}{'thr':>4}"
+    for _, title, _ in METRICS:
+        header += f"{title:>24}"
+    print(header)
+
+    regressions = 0
+    for key in sorted(base.keys() & new.keys()):
+        row = f"{key[0]:<14}{key[1]:<8}{key[2]:>4}"
+        regressed = False
+        for name, _, higher_is_better in METRICS:
+            old_value, new_value = base[key][name], new[key][name]
+            delta = change(old_value, new_value)
+            worse = -delta if higher_is_better else delta
+            if worse > args.threshold:
+                regressed = True
+            row += f"{new_value:>14.0f} ({delta:+6.1f}%)"
+        if regressed:
+            row += "  REGRESSION"
+            regressions += 1
+        print(row)
+
+    for key in sorted(base.keys() - new.keys()):
+        print(f"{key[0]:<14}{key[1]:<8}{key[2]:>4}  missing in {args.new}")
+    for key in sorted(new.keys() - base.keys()):
+        print(f"{key[0]:<14}{key[1]:<8}{key[2]:>4}  new in {args.new}")
+
+    print(f"\n{regressions} regression(s) above {args.threshold:.1f}%")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,240 @@
+#include "../include/AllocTrace.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <pthread.h>
+
+namespace memoryPool
+{
+
+namespace
+{
+
+// 日志文件头
+constexpr char TRACE_MAGIC[8] = {'M', 'P', 'T', 'R', 'A', 'C', 'E', '\0'};
+constexpr uint32_t TRACE_VERSION = 1;
+
+struct TraceHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t eventSize;
+};
+
+// 每个线程的记录缓冲区
+// busy 标记只在所属线程追加和 stop() 写出时竞争，平时是无竞争的原子操作
+struct ThreadBuffer : SystemAllocated
+{
+    static constexpr size_t CAPACITY = 4096;
+
+    std::atomic_flag busy = ATOMIC_FLAG_INIT;
+    uint32_t thread = 0;
+    size_t count = 0;
+    ThreadBuffer* nextBuffer = nullptr; // 全部缓冲区链表
+    ThreadBuffer* nextFree = nullptr;   // 已退出线程留下的缓冲区链表
+    AllocTrace::Event events[CAPACITY];
+};
+
+// 记录器的共享状态
+struct TraceState
+{
+    std::mutex mutex;                 // 保护以下全部字段
+    FILE* file = nullptr;
+    ThreadBuffer* buffers = nullptr;  // 所有创建过的缓冲区，stop() 时逐个写出
+    ThreadBuffer* freeBuffers = nullptr;
+    uint32_t nextThread = 1;
+};
+
+TraceState& state()
+{
+    static TraceState instance;
+    return instance;
+}
+
+__attribute__((tls_model("initial-exec")))
+thread_local ThreadBuffer* tlsBuffer = nullptr;
+
+// 把缓冲区中的记录追加到文件，调用者持有缓冲区的 busy 标记
+void flushBuffer(ThreadBuffer* buffer)
+{
+    if (buffer->count == 0) return;
+
+    TraceState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.file)
+    {
+        fwrite(buffer->events, sizeof(AllocTrace::Event), buffer->count, s.file);
+    }
+    buffer->count = 0;
+}
+
+void lockBuffer(ThreadBuffer* buffer)
+{
+    while (buffer->busy.test_and_set(std::memory_order_acquire))
+    {
+    }
+}
+
+void unlockBuffer(ThreadBuffer* buffer)
+{
+    buffer->busy.clear(std::memory_order_release);
+}
+
+// 线程退出时写出剩余记录，缓冲区留给新线程复用
+void releaseBuffer(void* ptr)
+{
+    ThreadBuffer* buffer = static_cast<ThreadBuffer*>(ptr);
+    tlsBuffer = nullptr;
+
+    lockBuffer(buffer);
+    flushBuffer(buffer);
+    unlockBuffer(buffer);
+
+    TraceState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    buffer->nextFree = s.freeBuffers;
+    s.freeBuffers = buffer;
+}
+
+pthread_key_t createBufferKey()
+{
+    pthread_key_t key;
+    pthread_key_create(&key, &releaseBuffer);
+    return key;
+}
+
+// 为当前线程取得缓冲区并分配线程编号
+ThreadBuffer* acquireBuffer()
+{
+    static pthread_key_t key = createBufferKey();
+
+    TraceState& s = state();
+    ThreadBuffer* buffer;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.freeBuffers)
+        {
+            buffer = s.freeBuffers;
+            s.freeBuffers = buffer->nextFree;
+        }
+        else
+        {
+            buffer = new ThreadBuffer;
+            buffer->nextBuffer = s.buffers;
+            s.buffers = buffer;
+        }
+        buffer->thread = s.nextThread++;
+    }
+
+    tlsBuffer = buffer;
+    pthread_setspecific(key, buffer);
+    return buffer;
+}
+
+} // namespace
+
+// 开始记录
+bool AllocTrace::start(const char* path)
+{
+    stop();
+
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+
+    TraceHeader header;
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.eventSize = sizeof(Event);
+    fwrite(&header, sizeof(header), 1, file);
+
+    TraceState& s = state();
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.file = file;
+    }
+    active_.store(true, std::memory_order_release);
+    return true;
+}
+
+// 停止记录
+void AllocTrace::stop()
+{
+    active_.store(false, std::memory_order_release);
+
+    TraceState& s = state();
+    ThreadBuffer* buffers;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        buffers = s.buffers;
+    }
+
+    // 缓冲区从不释放，可以在锁外遍历；逐个等待所属线程完成正在进行的追加后写出
+    for (ThreadBuffer* buffer = buffers; buffer; buffer = buffer->nextBuffer)
+    {
+        lockBuffer(buffer);
+        flushBuffer(buffer);
+        unlockBuffer(buffer);
+    }
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.file)
+    {
+        fclose(s.file);
+        s.file = nullptr;
+    }
+}
+
+// 追加一条记录到当前线程的缓冲区
+void AllocTrace::append(Op op, void* ptr, size_t size)
+{
+    ThreadBuffer* buffer = tlsBuffer;
+    if (!buffer) buffer = acquireBuffer();
+
+    Event event;
+    event.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    event.ptr = reinterpret_cast<uintptr_t>(ptr);
+    event.size = size > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(size);
+    event.thread = buffer->thread;
+    event.op = op;
+
+    lockBuffer(buffer);
+    // stop() 之后到达的记录直接丢弃
+    if (isActive())
+    {
+        buffer->events[buffer->count++] = event;
+        if (buffer->count == ThreadBuffer::CAPACITY)
+        {
+            flushBuffer(buffer);
+        }
+    }
+    unlockBuffer(buffer);
+}
+
+// 读取日志
+bool AllocTrace::readLog(const char* path, std::vector<Event>& events)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    TraceHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != TRACE_VERSION || header.eventSize != sizeof(Event))
+    {
+        fclose(file);
+        return false;
+    }
+
+    Event chunk[1024];
+    size_t n;
+    while ((n = fread(chunk, sizeof(Event), 1024, file)) > 0)
+    {
+        events.insert(events.end(), chunk, chunk + n);
+    }
+    fclose(file);
+    return true;
+}
+
+} // namespace memoryPool
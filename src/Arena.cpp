@@ -0,0 +1,100 @@
+#include "../include/Arena.h"
+#include <algorithm>
+
+namespace memoryPool
+{
+
+// 单次请求的上限，避免计算页数时溢出
+static const size_t MAX_ARENA_REQUEST = size_t(1) << 40;
+
+Arena::~Arena()
+{
+    rollback({nullptr, nullptr});
+    if (spare_)
+    {
+        PageCache::getInstance().deallocateSpan(spare_, spare_->numPages);
+    }
+}
+
+void* Arena::allocateSlow(size_t size, size_t alignment)
+{
+    if (size > MAX_ARENA_REQUEST || alignment > MAX_ARENA_REQUEST) return nullptr;
+
+    // 新 span 按页对齐，最坏情况下需要 alignment 字节的填充
+    size_t needed = sizeof(Chunk) + size + alignment;
+    size_t numPages = std::max(spanPages_, (needed + PageCache::PAGE_SIZE - 1) / PageCache::PAGE_SIZE);
+
+    Chunk* chunk;
+    if (spare_ && spare_->numPages >= numPages)
+    {
+        chunk = spare_;
+        spare_ = nullptr;
+    }
+    else
+    {
+        chunk = static_cast<Chunk*>(PageCache::getInstance().allocateSpan(numPages));
+        if (!chunk) return nullptr;
+        chunk->numPages = numPages;
+        reservedPages_ += numPages;
+    }
+
+    if (current_) current_->cursor = cursor_;
+    chunk->prev = current_;
+    current_ = chunk;
+    cursor_ = chunkBegin(chunk);
+    limit_ = chunkEnd(chunk);
+
+    return allocate(size, alignment);
+}
+
+void Arena::rollback(const Savepoint& savepoint)
+{
+    while (current_ != savepoint.chunk)
+    {
+        Chunk* chunk = current_;
+        current_ = chunk->prev;
+        releaseChunk(chunk);
+    }
+
+    if (current_)
+    {
+        cursor_ = savepoint.cursor;
+        limit_ = chunkEnd(current_);
+    }
+    else
+    {
+        cursor_ = limit_ = nullptr;
+    }
+}
+
+void Arena::reset()
+{
+    rollback({nullptr, nullptr});
+}
+
+size_t Arena::bytesUsed() const
+{
+    if (!current_) return 0;
+
+    size_t used = cursor_ - chunkBegin(current_);
+    for (Chunk* chunk = current_->prev; chunk; chunk = chunk->prev)
+    {
+        used += chunk->cursor - chunkBegin(chunk);
+    }
+    return used;
+}
+
+void Arena::releaseChunk(Chunk* chunk)
+{
+    // 从新到旧归还，最后留下的是最早的一段标准 span，reset 后从同一位置开始，缓存和 TLB 都是热的
+    if (chunk->numPages == spanPages_)
+    {
+        std::swap(chunk, spare_);
+        if (!chunk) return;
+    }
+
+    reservedPages_ -= chunk->numPages;
+    PageCache::getInstance().deallocateSpan(chunk, chunk->numPages);
+}
+
+} // namespace memoryPool
@@ -0,0 +1,160 @@
+#include "../include/AsyncRefill.h"
+#include "../include/CentralCache.h"
+#include "../include/PageCache.h"
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <pthread.h>
+
+namespace memoryPool
+{
+
+namespace
+{
+
+// 后台线程分离运行、不会退出，休眠用的锁和条件变量不能在进程退出时析构
+pthread_mutex_t helperMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t helperCond = PTHREAD_COND_INITIALIZER;
+
+// 是否有开启中的信箱
+bool anyActive(RefillMailbox* mailboxes)
+{
+    for (RefillMailbox* mailbox = mailboxes; mailbox; mailbox = mailbox->next)
+    {
+        if (mailbox->active.load(std::memory_order_relaxed)) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+RefillMailbox* AsyncRefill::attach(RefillMailbox* mailbox, void* owner)
+{
+    static std::once_flag started;
+    std::call_once(started, []
+    {
+        std::thread(&AsyncRefill::helperLoop).detach();
+    });
+
+    if (!mailbox)
+    {
+        // 信箱随线程缓存实例复用，从不释放，后台线程可以无锁遍历
+        mailbox = new RefillMailbox;
+        RefillMailbox* head = mailboxes_.load(std::memory_order_relaxed);
+        do
+        {
+            mailbox->next = head;
+        } while (!mailboxes_.compare_exchange_weak(head, mailbox, std::memory_order_release,
+                                                   std::memory_order_relaxed));
+    }
+
+    mailbox->owner = owner;
+    mailbox->active.store(true, std::memory_order_seq_cst);
+    wakeHelper();
+    return mailbox;
+}
+
+void AsyncRefill::detach(RefillMailbox* mailbox)
+{
+    // 与 helperLoop 中 busy/active 的检查顺序配对：
+    // 后台线程要么已看到关闭而跳过本信箱，要么在这里等它处理完
+    mailbox->active.store(false, std::memory_order_seq_cst);
+    while (mailbox->busy.load(std::memory_order_seq_cst))
+    {
+        std::this_thread::yield();
+    }
+
+    // 未处理的请求作废
+    mailbox->requests.clear();
+}
+
+void AsyncRefill::wakeHelper()
+{
+    pthread_mutex_lock(&helperMutex);
+    pthread_cond_signal(&helperCond);
+    pthread_mutex_unlock(&helperMutex);
+}
+
+bool AsyncRefill::serve(RefillMailbox* mailbox)
+{
+    bool worked = false;
+    RefillMailbox::Request request;
+
+    // 回复队列满时暂停，等所属线程取走
+    while (!mailbox->batches.full() && mailbox->requests.pop(request))
+    {
+        RefillMailbox::Batch batch{nullptr, nullptr, request.index, 0};
+        batch.head = request.central->fetchRange(request.index, request.count);
+        if (batch.head)
+        {
+            PageCache::claimSpanOwners(batch.head, mailbox->owner);
+
+            // 中心缓存可能返回少于请求个数的内存块
+            void* current = batch.head;
+            batch.count = 1;
+            while (void* next = *reinterpret_cast<void**>(current))
+            {
+                current = next;
+                batch.count++;
+            }
+            batch.tail = current;
+        }
+
+        mailbox->batches.push(batch);
+        delivered_.fetch_add(1, std::memory_order_relaxed);
+        worked = true;
+    }
+    return worked;
+}
+
+void AsyncRefill::helperLoop()
+{
+    for (;;)
+    {
+        bool worked = false;
+        bool active = false;
+        for (RefillMailbox* mailbox = mailboxes_.load(std::memory_order_acquire); mailbox;
+             mailbox = mailbox->next)
+        {
+            if (!mailbox->active.load(std::memory_order_relaxed)) continue;
+            active = true;
+
+            mailbox->busy.store(true, std::memory_order_seq_cst);
+            if (mailbox->active.load(std::memory_order_seq_cst))
+            {
+                worked |= serve(mailbox);
+            }
+            mailbox->busy.store(false, std::memory_order_release);
+        }
+        if (worked) continue;
+
+        pthread_mutex_lock(&helperMutex);
+        if (!active)
+        {
+            // 所有线程都已关闭时一直休眠，直到 attach 唤醒
+            while (!anyActive(mailboxes_.load(std::memory_order_acquire)))
+            {
+                pthread_cond_wait(&helperCond, &helperMutex);
+            }
+        }
+        else
+        {
+            // 没有请求时休眠；错过的唤醒最多延迟 1 毫秒
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 1000000;
+            if (deadline.tv_nsec >= 1000000000)
+            {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+
+            sleeping_.store(true, std::memory_order_seq_cst);
+            pthread_cond_timedwait(&helperCond, &helperMutex, &deadline);
+            sleeping_.store(false, std::memory_order_relaxed);
+        }
+        pthread_mutex_unlock(&helperMutex);
+    }
+}
+
+} // namespace memoryPool
@@ -1,5 +1,6 @@
 #include "../include/CentralCache.h"
 #include "../include/PageCache.h"
+#include "../include/Instrument.h"
 #include <cassert>
 #include <thread>
 
@@ -17,91 +18,49 @@ static const size_t SPAN_PAGES = 8;
 void* CentralCache::fetchRange(size_t index, size_t batchNum)
 {
     // 输入有效性检查：索引超出范围或请求数量为0时返回空
-    if (index >= FREE_LIST_SIZE || batchNum == 0) 
+    if (index >= FREE_LIST_SIZE || batchNum == 0)
         return nullptr;
 
     // 使用自旋锁保护临界区，确保线程安全
+    MEMORY_POOL_PROBE_START(waitStart);
     while (locks_[index].test_and_set(std::memory_order_acquire))
     {
         std::this_thread::yield(); // 线程让步，避免忙等待，降低 CPU 占用
     }
+    MEMORY_POOL_PROBE_START(holdStart);
+    MEMORY_POOL_PROBE_END(CENTRAL_FETCH_WAIT, waitStart);
 
-    void* result = nullptr;
-    try 
-    {
-        // 尝试从中心缓存的自由链表获取内存块
-        result = centralFreeList_[index].load(std::memory_order_relaxed);
+    ClassSlabs& slabs = slabs_[index];
+    void* head = nullptr;
+    void* tail = nullptr;
+    size_t taken = 0;
 
-        if (!result) // 如果自由链表为空
+    try
+    {
+        while (taken < batchNum)
         {
-            // 根据索引计算内存块大小
-            size_t size = (index + 1) * ALIGNMENT;
-            // 从页缓存获取新的内存
-            result = fetchFromPageCache(size);
-
-            if (!result) // 如果页缓存分配失败
+            // 优先选择最满的部分使用 slab，其次是保留的全空 slab，最后才向页缓存申请
+            Span* span = pickSpan(slabs);
+            if (!span)
             {
-                locks_[index].clear(std::memory_order_release);
-                return nullptr;
-            }
-
-            // 将从页缓存获取的内存切分成小块
-            char* start = static_cast<char*>(result);
-            size_t totalBlocks = (SPAN_PAGES * PageCache::PAGE_SIZE) / size; // 总块数
-            size_t allocBlocks = std::min(batchNum, totalBlocks); // 分配块数
-
-            // 构建返回给线程缓存的内存块链表
-            if (allocBlocks > 1) 
-            {  
-                for (size_t i = 1; i < allocBlocks; ++i) 
+                // 向页缓存申请（可能 mmap）期间释放类别锁，其他线程仍可从已有 slab 取块、归还内存块
+                Span* fresh = fetchUnlocked(index);
+                if (fresh)
                 {
-                    void* current = start + (i - 1) * size;
-                    void* next = start + i * size;
-                    *reinterpret_cast<void**>(current) = next; // 链接内存块
+                    updateSpanList(slabs, fresh);
                 }
-                *reinterpret_cast<void**>(start + (allocBlocks - 1) * size) = nullptr; // 链表尾置空
-            }
-
-            // 构建保留在中心缓存的链表
-            if (totalBlocks > allocBlocks)
-            {
-                void* remainStart = start + allocBlocks * size;
-                for (size_t i = allocBlocks + 1; i < totalBlocks; ++i)
+                else if (!pickSpan(slabs))
                 {
-                    void* current = start + (i - 1) * size;
-                    void* next = start + i * size;
-                    *reinterpret_cast<void**>(current) = next;
+                    break; // 页缓存分配失败，且期间没有其他线程补充，返回已取到的部分
                 }
-                *reinterpret_cast<void**>(start + (totalBlocks - 1) * size) = nullptr;
-
-                // 更新中心缓存的自由链表
-                centralFreeList_[index].store(remainStart, std::memory_order_release);
-            }
-        } 
-        else // 如果自由链表不为空
-        {
-            // 从现有链表中获取指定数量的块
-            void* current = result;
-            void* prev = nullptr;
-            size_t count = 0;
-
-            while (current && count < batchNum)
-            {
-                prev = current;
-                current = *reinterpret_cast<void**>(current);
-                count++;
-            }
-
-            if (prev) 
-            {
-                *reinterpret_cast<void**>(prev) = nullptr; // 截断链表
+                continue; // 重新选择：期间其他线程可能已补充或归还
             }
 
-            // 更新自由链表头指针
-            centralFreeList_[index].store(current, std::memory_order_release);
+            taken += takeBlocks(span, batchNum - taken, head, tail);
+            updateSpanList(slabs, span);
         }
     }
-    catch (...) 
+    catch (...)
     {
         locks_[index].clear(std::memory_order_release); // 异常时释放锁
         throw;
@@ -109,70 +68,390 @@ void* CentralCache::fetchRange(size_t index, size_t batchNum)
 
     // 释放自旋锁
     locks_[index].clear(std::memory_order_release);
-    return result;
+    MEMORY_POOL_PROBE_END(CENTRAL_FETCH_HOLD, holdStart);
+
+    if (tail)
+    {
+        *reinterpret_cast<void**>(tail) = nullptr; // 链表尾置空
+    }
+    return head;
 }
 
 // 将一批内存块归还到中心缓存
 // 参数 start: 归还的内存块链表起始地址
-// 参数 size: 单个内存块大小
-// 参数 index: 自由链表索引（代码中未直接使用 bytes 参数，应为 index）
+// 参数 size: 归还的总字节数（未使用，链表以 nullptr 结尾）
+// 参数 index: 自由链表索引
 void CentralCache::returnRange(void* start, size_t size, size_t index)
 {
     // 输入有效性检查：指针为空或索引无效时直接返回
-    if (!start || index >= FREE_LIST_SIZE) 
+    if (!start || index >= FREE_LIST_SIZE)
         return;
 
     // 使用自旋锁保护临界区
-    while (locks_[index].test_and_set(std::memory_order_acquire)) 
+    MEMORY_POOL_PROBE_START(waitStart);
+    while (locks_[index].test_and_set(std::memory_order_acquire))
     {
         std::this_thread::yield();
     }
+    MEMORY_POOL_PROBE_START(holdStart);
+    MEMORY_POOL_PROBE_END(CENTRAL_RETURN_WAIT, waitStart);
+
+    ClassSlabs& slabs = slabs_[index];
+
+    try
+    {
+        void* current = start;
+        while (current)
+        {
+            void* next = *reinterpret_cast<void**>(current);
+
+            // 通过页表找到内存块所属的 slab，在空闲位图中标记为空闲
+            Span* span = PageCache::mapObjectToSpan(current);
+            assert(span && span->objSize == (index + 1) * ALIGNMENT);
+
+            size_t block = (static_cast<char*>(current) - static_cast<char*>(span->pageAddr) - span->color) / span->objSize;
+            size_t word = block / 64;
+            span->freeBitmap[word] |= uint64_t(1) << (block % 64);
+            span->searchHint = std::min(span->searchHint, word);
+            span->useCount--;
+
+            updateSpanList(slabs, span);
+
+            if (span->listId == EMPTY_LIST)
+            {
+                // 全空 slab 不再属于任何线程，下次由取走它的线程重新认领
+                span->owner.store(nullptr, std::memory_order_release);
+
+                // 全空 slab 超过保留数量时归还给页缓存
+                if (slabs.lists[EMPTY_LIST].count > MAX_EMPTY_SPANS)
+                {
+                    listRemove(slabs.lists[EMPTY_LIST], span);
+                    releaseToPageCache(span);
+                }
+            }
+
+            current = next;
+        }
+    }
+    catch (...)
+    {
+        locks_[index].clear(std::memory_order_release);
+        throw;
+    }
+
+    locks_[index].clear(std::memory_order_release);
+    MEMORY_POOL_PROBE_END(CENTRAL_RETURN_HOLD, holdStart);
+}
+
+// 汇总每个大小类别 slab 中的空闲字节数
+void CentralCache::collectStats(PoolStats& stats)
+{
+    for (size_t index = 0; index < FREE_LIST_SIZE; ++index)
+    {
+        while (locks_[index].test_and_set(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+
+        size_t freeBytes = 0;
+        for (const SpanList& list : slabs_[index].lists)
+        {
+            for (const Span* span = list.head; span; span = span->next)
+            {
+                freeBytes += (span->totalBlocks - span->useCount) * span->objSize;
+            }
+        }
+
+        locks_[index].clear(std::memory_order_release);
+
+        stats.classes[index].centralFreeBytes += freeBytes;
+        stats.centralCacheBytes += freeBytes;
+    }
+}
 
-    try 
+// 归还全部全空 slab
+size_t CentralCache::releaseEmptySpans()
+{
+    size_t released = 0;
+    for (size_t index = 0; index < FREE_LIST_SIZE; ++index)
     {
-        // 找到归还链表的尾部
-        void* end = start;
-        size_t count = 1;
-        while (*reinterpret_cast<void**>(end) != nullptr && count < size) 
+        while (locks_[index].test_and_set(std::memory_order_acquire))
         {
-            end = *reinterpret_cast<void**>(end);
-            count++;
+            std::this_thread::yield();
         }
 
-        // 将归还链表连接到中心缓存自由链表头部
-        void* current = centralFreeList_[index].load(std::memory_order_relaxed);
-        *reinterpret_cast<void**>(end) = current; // 尾部指向原链表头
-        centralFreeList_[index].store(start, std::memory_order_release); // 更新链表头
+        SpanList& empty = slabs_[index].lists[EMPTY_LIST];
+        while (Span* span = empty.head)
+        {
+            listRemove(empty, span);
+            released += span->numPages * PageCache::PAGE_SIZE;
+            releaseToPageCache(span);
+        }
+
+        locks_[index].clear(std::memory_order_release);
     }
-    catch (...) 
+    return released;
+}
+
+// 为大小类别预先切分 slab
+bool CentralCache::reserve(size_t index, size_t count)
+{
+    if (index >= FREE_LIST_SIZE) return false;
+
+    while (locks_[index].test_and_set(std::memory_order_acquire))
+    {
+        std::this_thread::yield();
+    }
+
+    ClassSlabs& slabs = slabs_[index];
+    bool ok = true;
+    try
+    {
+        // 申请新 slab 期间释放了类别锁，每次重新加锁后重新统计
+        while (freeBlocksOf(slabs) < count)
+        {
+            Span* span = fetchUnlocked(index);
+            if (!span)
+            {
+                ok = false;
+                break;
+            }
+            updateSpanList(slabs, span);
+        }
+    }
+    catch (...)
     {
         locks_[index].clear(std::memory_order_release);
         throw;
     }
 
     locks_[index].clear(std::memory_order_release);
+    return ok;
 }
 
-// 从页缓存获取内存
-// 参数 size: 请求的内存块大小
-// 返回值: 指向从页缓存获取的内存的指针
-void* CentralCache::fetchFromPageCache(size_t size)
-{   
-    // 计算需要的页数，向上取整
-    size_t numPages = (size + PageCache::PAGE_SIZE - 1) / PageCache::PAGE_SIZE;
+// 丢弃全部 slab
+void CentralCache::releaseAll()
+{
+    for (size_t index = 0; index < FREE_LIST_SIZE; ++index)
+    {
+        for (SpanList& list : slabs_[index].lists)
+        {
+            for (Span* span = list.head; span; span = span->next)
+            {
+                SystemAllocator<uint64_t>().deallocate(span->freeBitmap, 0);
+            }
+            list = SpanList{};
+        }
+    }
+}
 
-    // 根据大小决定分配策略
-    if (size <= SPAN_PAGES * PageCache::PAGE_SIZE) 
+// 选择取块的 slab
+Span* CentralCache::pickSpan(ClassSlabs& slabs)
+{
+    for (int list = PARTIAL_LISTS - 1; list >= 0; --list)
     {
-        // 小于等于 32KB 的请求，分配固定 8 页
-        return PageCache::getInstance().allocateSpan(SPAN_PAGES);
-    } 
-    else 
+        if (slabs.lists[list].head) return slabs.lists[list].head;
+    }
+    return slabs.lists[EMPTY_LIST].head;
+}
+
+// 统计大小类别的空闲内存块数
+size_t CentralCache::freeBlocksOf(const ClassSlabs& slabs)
+{
+    size_t freeBlocks = 0;
+    for (const SpanList& list : slabs.lists)
     {
-        // 大于 32KB 的请求，按实际需求分配页数
-        return PageCache::getInstance().allocateSpan(numPages);
+        for (const Span* span = list.head; span; span = span->next)
+        {
+            freeBlocks += span->totalBlocks - span->useCount;
+        }
     }
+    return freeBlocks;
 }
 
-} // namespace memoryPool
+// 释放类别锁后从页缓存获取新 slab，返回前重新加锁
+Span* CentralCache::fetchUnlocked(size_t index)
+{
+    locks_[index].clear(std::memory_order_release);
+
+    Span* span = nullptr;
+    try
+    {
+        span = fetchFromPageCache(index);
+    }
+    catch (...)
+    {
+        // 调用者的异常处理会释放锁，这里先重新持有
+        while (locks_[index].test_and_set(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+        throw;
+    }
+
+    while (locks_[index].test_and_set(std::memory_order_acquire))
+    {
+        std::this_thread::yield();
+    }
+    return span;
+}
+
+// 从页缓存获取新的 span 并初始化为 slab
+// 参数 index: 大小类别索引
+// 返回值: 新的 slab
+Span* CentralCache::fetchFromPageCache(size_t index)
+{
+    size_t size = (index + 1) * ALIGNMENT;
+    size_t numPages = spanPagesFor(size);
+
+    void* memory = pageCache_.allocateSpan(numPages, size);
+    if (!memory) return nullptr;
+
+    Span* span = PageCache::mapObjectToSpan(memory);
+
+    // 按类别轮换颜色，不同类别从不同的颜色开始
+    size_t blocks, colors, step;
+    slabLayout(size, numPages, blocks, colors, step);
+    span->color = (slabs_[index].nextColor.fetch_add(1, std::memory_order_relaxed) + index) % colors * step;
+
+    // 初始化空闲位图：所有内存块空闲
+    span->totalBlocks = blocks;
+    span->useCount = 0;
+    span->searchHint = 0;
+    span->listId = -1;
+    span->central = this;
+
+    size_t words = (span->totalBlocks + 63) / 64;
+    span->freeBitmap = SystemAllocator<uint64_t>().allocate(words);
+    for (size_t i = 0; i < words; ++i)
+    {
+        span->freeBitmap[i] = ~uint64_t(0);
+    }
+    if (span->totalBlocks % 64)
+    {
+        span->freeBitmap[words - 1] = (uint64_t(1) << (span->totalBlocks % 64)) - 1;
+    }
+
+    return span;
+}
+
+// 把全空的 slab 归还给页缓存
+void CentralCache::releaseToPageCache(Span* span)
+{
+    SystemAllocator<uint64_t>().deallocate(span->freeBitmap, 0);
+    span->freeBitmap = nullptr;
+    span->listId = -1;
+
+    pageCache_.deallocateSpan(span->pageAddr, span->numPages);
+}
 
+// 从 slab 中按地址顺序取出空闲内存块
+size_t CentralCache::takeBlocks(Span* span, size_t n, void*& head, void*& tail)
+{
+    size_t words = (span->totalBlocks + 63) / 64;
+    char* base = static_cast<char*>(span->pageAddr) + span->color;
+    size_t taken = 0;
+
+    size_t word = span->searchHint;
+    for (; word < words && taken < n; ++word)
+    {
+        uint64_t bits = span->freeBitmap[word];
+        while (bits && taken < n)
+        {
+            size_t bit = __builtin_ctzll(bits);
+            bits &= bits - 1; // 清除最低位的 1
+
+            void* block = base + (word * 64 + bit) * span->objSize;
+            if (tail)
+            {
+                *reinterpret_cast<void**>(tail) = block;
+            }
+            else
+            {
+                head = block;
+            }
+            tail = block;
+            ++taken;
+        }
+        span->freeBitmap[word] = bits;
+
+        // 当前字还有空闲位，下次从这里继续查找
+        if (bits) break;
+    }
+    span->searchHint = word;
+    span->useCount += taken;
+    return taken;
+}
+
+// 计算 slab 应当所在的链表
+int CentralCache::listFor(const Span* span)
+{
+    if (span->useCount == 0) return EMPTY_LIST;
+    if (span->useCount == span->totalBlocks) return FULL_LIST;
+
+    // 部分使用：满度越高，链表编号越大
+    return static_cast<int>(span->useCount * PARTIAL_LISTS / span->totalBlocks);
+}
+
+// 根据满度移动 slab
+void CentralCache::updateSpanList(ClassSlabs& slabs, Span* span)
+{
+    int target = listFor(span);
+    if (target == span->listId) return;
+
+    if (span->listId >= 0)
+    {
+        listRemove(slabs.lists[span->listId], span);
+    }
+    listPush(slabs.lists[target], span);
+    span->listId = target;
+}
+
+void CentralCache::listPush(SpanList& list, Span* span)
+{
+    span->prev = nullptr;
+    span->next = list.head;
+    if (list.head) list.head->prev = span;
+    list.head = span;
+    list.count++;
+}
+
+void CentralCache::listRemove(SpanList& list, Span* span)
+{
+    if (span->prev) span->prev->next = span->next;
+    else list.head = span->next;
+    if (span->next) span->next->prev = span->prev;
+    span->prev = span->next = nullptr;
+    list.count--;
+}
+
+// 计算大小类别对应的 span 页数
+size_t CentralCache::spanPagesFor(size_t size)
+{
+    // 小于等于 32KB 的内存块使用固定 8 页的 span，更大的按实际需求分配页数
+    size_t numPages = (size + PageCache::PAGE_SIZE - 1) / PageCache::PAGE_SIZE;
+    return std::max(SPAN_PAGES, numPages);
+}
+
+// 计算 slab 的切分方式
+void CentralCache::slabLayout(size_t size, size_t numPages, size_t& blocks, size_t& colors, size_t& step)
+{
+    size_t spanBytes = numPages * PageCache::PAGE_SIZE;
+    blocks = spanBytes / size;
+    size_t slack = spanBytes - blocks * size;
+
+    // 颜色须保持内存块的自然对齐（大小的最低位，最多一页），且至少一个缓存行
+    step = std::max(COLOR_STEP, std::min(size & (~size + 1), PageCache::PAGE_SIZE));
+
+    // 剩余空间不足时舍弃末尾的内存块，直到达到期望的着色范围或舍弃过多
+    size_t target = std::max(COLOR_SPACE, step);
+    while (slack < target && blocks > 1 && slack + size <= spanBytes / MAX_COLOR_WASTE)
+    {
+        --blocks;
+        slack += size;
+    }
+
+    colors = slack / step + 1;
+}
+
+} // namespace memoryPool
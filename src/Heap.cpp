@@ -0,0 +1,168 @@
+#include "../include/Heap.h"
+#include "../include/CentralCache.h"
+#include "../include/PageCache.h"
+#include "../include/ThreadCache.h"
+#include <new>
+#include <sys/mman.h>
+
+namespace memoryPool
+{
+
+namespace
+{
+
+// 堆的元数据较大（中心缓存按大小类别展开），直接用 mmap 分配，不经过任何堆
+void* mapMemory(size_t size)
+{
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) throw std::bad_alloc();
+    return memory;
+}
+
+template <typename T>
+void unmapObject(T* object)
+{
+    object->~T();
+    munmap(object, sizeof(T));
+}
+
+} // namespace
+
+Heap::Heap()
+{
+    pageCache_ = new (mapMemory(sizeof(PageCache))) PageCache;
+    centralCache_ = new (mapMemory(sizeof(CentralCache))) CentralCache(*pageCache_);
+    if (pthread_key_create(&key_, &Heap::releaseThreadCache) != 0)
+    {
+        unmapObject(centralCache_);
+        unmapObject(pageCache_);
+        throw std::bad_alloc();
+    }
+}
+
+Heap::~Heap()
+{
+    destroy();
+
+    // 删除 key 之后，仍持有本堆线程缓存的线程退出时不会再调用 releaseThreadCache
+    pthread_key_delete(key_);
+
+    ThreadCache* cache = instances_;
+    while (cache)
+    {
+        ThreadCache* next = cache->nextInstance_;
+        unmapObject(cache);
+        cache = next;
+    }
+
+    unmapObject(centralCache_);
+    unmapObject(pageCache_);
+}
+
+void* Heap::allocate(size_t size)
+{
+    if (__builtin_expect(size > MAX_BYTES, 0))
+    {
+        largeAllocs_.fetch_add(1, std::memory_order_relaxed);
+        return pageCache_->allocateSpan(largePages(size));
+    }
+    return threadCache()->allocate(size);
+}
+
+void Heap::deallocate(void* ptr, size_t size)
+{
+    if (!ptr) return;
+
+    if (__builtin_expect(size > MAX_BYTES, 0))
+    {
+        largeFrees_.fetch_add(1, std::memory_order_relaxed);
+        pageCache_->deallocateSpan(ptr, largePages(size));
+        return;
+    }
+    threadCache()->deallocate(ptr, size);
+}
+
+void Heap::destroy()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // 各线程缓存的链表指向即将解除映射的内存，只清空链表头，不访问内存块
+    for (ThreadCache* cache = instances_; cache; cache = cache->nextInstance_)
+    {
+        cache->discardAll();
+        cache->allocCount_.fill(0);
+        cache->freeCount_.fill(0);
+        cache->wastedBytes_.fill(0);
+    }
+
+    // 中心缓存先释放 slab 的空闲位图，页缓存再删除 span 元数据并解除映射
+    centralCache_->releaseAll();
+    pageCache_->releaseAll();
+
+    largeAllocs_.store(0, std::memory_order_relaxed);
+    largeFrees_.store(0, std::memory_order_relaxed);
+}
+
+PoolStats Heap::getStats()
+{
+    PoolStats stats;
+    stats.expandClasses();
+
+    pageCache_->collectStats(stats);
+    centralCache_->collectStats(stats);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ThreadCache::collectStats(stats, instances_);
+    }
+    stats.largeAllocs += largeAllocs_.load(std::memory_order_relaxed);
+    stats.largeFrees += largeFrees_.load(std::memory_order_relaxed);
+
+    stats.compactClasses();
+    return stats;
+}
+
+ThreadCache* Heap::createThreadCache()
+{
+    ThreadCache* cache = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (recycled_)
+        {
+            cache = recycled_;
+            recycled_ = cache->nextRecycled_;
+            cache->alive_.store(true, std::memory_order_release);
+        }
+        else
+        {
+            cache = ThreadCache::createForHeap(*centralCache_);
+            if (!cache) throw std::bad_alloc();
+            cache->heap_ = this;
+            cache->nextInstance_ = instances_;
+            instances_ = cache;
+        }
+    }
+
+    pthread_setspecific(key_, cache);
+    return cache;
+}
+
+void Heap::releaseThreadCache(void* instance)
+{
+    ThreadCache* cache = static_cast<ThreadCache*>(instance);
+    Heap* heap = cache->heap_;
+
+    // 与全局线程缓存的退出流程相同：先停止接收远程释放，再归还全部内存块
+    cache->alive_.store(false, std::memory_order_release);
+    cache->releaseAll();
+
+    std::lock_guard<std::mutex> lock(heap->mutex_);
+    cache->nextRecycled_ = heap->recycled_;
+    heap->recycled_ = cache;
+}
+
+size_t Heap::largePages(size_t size)
+{
+    return (size + PageCache::PAGE_SIZE - 1) / PageCache::PAGE_SIZE;
+}
+
+} // namespace memoryPool
@@ -0,0 +1,263 @@
+#include "../include/HeapProfiler.h"
+#include "../include/PageCache.h"
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+#include <execinfo.h>
+#include <sys/mman.h>
+
+namespace memoryPool
+{
+
+namespace
+{
+
+// 采样区间大小：只预留地址空间，页面在对象分配时才被访问
+constexpr size_t REGION_SIZE = size_t(1) << 30; // 1GB
+constexpr size_t REGION_PAGES = REGION_SIZE / PageCache::PAGE_SIZE;
+
+// 跳过分析器自身和 ThreadCache 采样入口的栈帧
+constexpr int SKIP_FRAMES = 2;
+
+// 采样分析器的共享状态，全部由 mutex 保护
+struct ProfilerState
+{
+    std::mutex mutex;
+
+    // 采样区间的页位图，第 i 位为 1 表示第 i 页已被占用
+    std::vector<uint64_t, SystemAllocator<uint64_t>> usedPages;
+
+    // 存活的采样对象，按地址索引
+    std::unordered_map<uintptr_t, HeapProfiler::Sample, std::hash<uintptr_t>, std::equal_to<uintptr_t>,
+                       SystemAllocator<std::pair<const uintptr_t, HeapProfiler::Sample>>> samples;
+};
+
+ProfilerState& state()
+{
+    static ProfilerState instance;
+    return instance;
+}
+
+size_t pagesFor(size_t size)
+{
+    return std::max<size_t>(1, (size + PageCache::PAGE_SIZE - 1) / PageCache::PAGE_SIZE);
+}
+
+bool pageUsed(const ProfilerState& s, size_t page)
+{
+    return (s.usedPages[page / 64] >> (page % 64)) & 1;
+}
+
+void markPages(ProfilerState& s, size_t first, size_t count, bool used)
+{
+    for (size_t page = first; page < first + count; ++page)
+    {
+        uint64_t bit = uint64_t(1) << (page % 64);
+        if (used) s.usedPages[page / 64] |= bit;
+        else s.usedPages[page / 64] &= ~bit;
+    }
+}
+
+// 首次适应查找 count 个连续空闲页，找不到返回 REGION_PAGES
+size_t findFreePages(const ProfilerState& s, size_t count)
+{
+    size_t runStart = 0;
+    size_t runLength = 0;
+    for (size_t page = 0; page < REGION_PAGES; ++page)
+    {
+        // 整个字都被占用时直接跳过
+        if (page % 64 == 0 && s.usedPages[page / 64] == ~uint64_t(0))
+        {
+            runLength = 0;
+            page += 63;
+            continue;
+        }
+
+        if (pageUsed(s, page))
+        {
+            runLength = 0;
+            continue;
+        }
+
+        if (runLength == 0) runStart = page;
+        if (++runLength == count) return runStart;
+    }
+    return REGION_PAGES;
+}
+
+uint64_t nowNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+// 开始采样
+void HeapProfiler::start(size_t sampleRate)
+{
+    ProfilerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    // 首次启动时预留采样区间，之后不再释放，保证 isSampled 始终有效
+    if (regionSize_.load(std::memory_order_relaxed) == 0)
+    {
+        void* region = mmap(nullptr, REGION_SIZE, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (region == MAP_FAILED) return;
+
+        s.usedPages.assign(REGION_PAGES / 64, 0);
+        regionBase_.store(reinterpret_cast<uintptr_t>(region), std::memory_order_relaxed);
+        regionSize_.store(REGION_SIZE, std::memory_order_release);
+
+        // backtrace 第一次调用时会加载 libgcc 并分配内存，提前在这里完成，避免发生在分配路径上
+        void* frames[1];
+        backtrace(frames, 1);
+    }
+
+    sampleRate_.store(std::max<size_t>(sampleRate, 1), std::memory_order_relaxed);
+    active_.store(true, std::memory_order_release);
+}
+
+// 停止采样
+void HeapProfiler::stop()
+{
+    active_.store(false, std::memory_order_release);
+}
+
+// 在采样区间中分配一个对象并记录调用栈
+void* HeapProfiler::allocateSampled(size_t size)
+{
+    Sample sample;
+    sample.size = size;
+    sample.timestamp = nowNanos();
+
+    // 在锁外抓取调用栈
+    void* frames[MAX_STACK_DEPTH + SKIP_FRAMES];
+    int depth = backtrace(frames, MAX_STACK_DEPTH + SKIP_FRAMES);
+    sample.depth = std::max(0, depth - SKIP_FRAMES);
+    std::copy(frames + SKIP_FRAMES, frames + SKIP_FRAMES + sample.depth, sample.stack);
+
+    ProfilerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    size_t pages = pagesFor(size);
+    size_t first = findFreePages(s, pages);
+    if (first == REGION_PAGES) return nullptr; // 采样区间已满，本次不采样
+
+    markPages(s, first, pages, true);
+    sample.ptr = reinterpret_cast<void*>(regionBase_.load(std::memory_order_relaxed) +
+                                         first * PageCache::PAGE_SIZE);
+    s.samples.emplace(reinterpret_cast<uintptr_t>(sample.ptr), sample);
+    return sample.ptr;
+}
+
+// 释放采样对象
+void HeapProfiler::deallocateSampled(void* ptr)
+{
+    ProfilerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    auto it = s.samples.find(reinterpret_cast<uintptr_t>(ptr));
+    if (it == s.samples.end()) return;
+
+    size_t pages = pagesFor(it->second.size);
+    size_t first = (reinterpret_cast<uintptr_t>(ptr) - regionBase_.load(std::memory_order_relaxed)) /
+                   PageCache::PAGE_SIZE;
+    s.samples.erase(it);
+
+    // 归还物理页，地址留在采样区间中供后续采样复用
+    madvise(ptr, pages * PageCache::PAGE_SIZE, MADV_DONTNEED);
+    markPages(s, first, pages, false);
+}
+
+// 查询采样对象的大小
+size_t HeapProfiler::sampledObjectSize(void* ptr)
+{
+    ProfilerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    auto it = s.samples.find(reinterpret_cast<uintptr_t>(ptr));
+    return it == s.samples.end() ? 0 : it->second.size;
+}
+
+// 按几何分布生成下一次采样前的字节数
+// 采样间隔服从均值为 sampleRate 的指数分布，使每个字节被抽中的概率相同（同 tcmalloc）
+size_t HeapProfiler::nextSampleInterval(uint64_t& rng)
+{
+    if (rng == 0)
+    {
+        rng = nowNanos() ^ reinterpret_cast<uintptr_t>(&rng) ^ 0x9e3779b97f4a7c15ULL;
+    }
+
+    // xorshift64*
+    rng ^= rng >> 12;
+    rng ^= rng << 25;
+    rng ^= rng >> 27;
+    uint64_t bits = rng * 0x2545f4914f6cdd1dULL;
+
+    // 取 53 位生成 (0, 1] 内的均匀分布
+    double u = static_cast<double>((bits >> 11) + 1) * (1.0 / 9007199254740992.0);
+    double interval = -std::log(u) * static_cast<double>(sampleRate());
+    return static_cast<size_t>(std::min(interval, 1e15)) + 1;
+}
+
+// 获取所有存活采样对象的快照
+std::vector<HeapProfiler::Sample, SystemAllocator<HeapProfiler::Sample>> HeapProfiler::getSamples()
+{
+    ProfilerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    std::vector<Sample, SystemAllocator<Sample>> result;
+    result.reserve(s.samples.size());
+    for (const auto& entry : s.samples)
+    {
+        result.push_back(entry.second);
+    }
+    std::sort(result.begin(), result.end(),
+              [](const Sample& a, const Sample& b) { return a.timestamp < b.timestamp; });
+    return result;
+}
+
+// 以 pprof 旧版堆文本格式输出
+// 每个采样对象输出一行，pprof 根据头部的 heap_v2/<rate> 按采样概率还原真实的对象数和字节数
+void HeapProfiler::dump(FILE* out)
+{
+    auto samples = getSamples();
+
+    size_t totalBytes = 0;
+    for (const Sample& sample : samples)
+    {
+        totalBytes += sample.size;
+    }
+
+    fprintf(out, "heap profile: %zu: %zu [%zu: %zu] @ heap_v2/%zu\n",
+            samples.size(), totalBytes, samples.size(), totalBytes, sampleRate());
+
+    for (const Sample& sample : samples)
+    {
+        fprintf(out, "1: %zu [1: %zu] @", sample.size, sample.size);
+        for (int i = 0; i < sample.depth; ++i)
+        {
+            fprintf(out, " %p", sample.stack[i]);
+        }
+        fprintf(out, "\n");
+    }
+
+    // 附带内存映射，供 pprof 把地址对应到可执行文件和共享库
+    fprintf(out, "\nMAPPED_LIBRARIES:\n");
+    if (FILE* maps = fopen("/proc/self/maps", "r"))
+    {
+        char buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), maps)) > 0)
+        {
+            fwrite(buffer, 1, n, out);
+        }
+        fclose(maps);
+    }
+    fflush(out);
+}
+
+} // namespace memoryPool
@@ -0,0 +1,202 @@
+#include "../include/Instrument.h"
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <pthread.h>
+
+namespace memoryPool
+{
+
+namespace
+{
+
+// 每个线程的直方图组，线程退出后留给新线程复用（计数保留，合并结果因此覆盖已退出的线程）
+struct ThreadHistograms : SystemAllocated
+{
+    Instrument::Histogram histograms[Instrument::NUM_PROBES];
+    ThreadHistograms* nextAll = nullptr;
+    ThreadHistograms* nextFree = nullptr;
+};
+
+struct Registry
+{
+    std::mutex mutex;
+    ThreadHistograms* all = nullptr;
+    ThreadHistograms* free = nullptr;
+};
+
+Registry& registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+pthread_key_t createThreadKey(void (*destructor)(void*))
+{
+    pthread_key_t key;
+    pthread_key_create(&key, destructor);
+    return key;
+}
+
+// 估算计数器频率（每纳秒的计数），只在第一次输出时测量一次
+double countsPerNanosecond()
+{
+    static double rate = []()
+    {
+        auto wallStart = std::chrono::steady_clock::now();
+        uint64_t start = Instrument::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint64_t end = Instrument::now();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - wallStart).count();
+        return ns > 0 ? (end - start) / ns : 1.0;
+    }();
+    return rate;
+}
+
+} // namespace
+
+Instrument::Histogram* Instrument::registerThread()
+{
+    static pthread_key_t key = createThreadKey(&Instrument::releaseThread);
+
+    Registry& r = registry();
+    ThreadHistograms* group;
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        if (r.free)
+        {
+            group = r.free;
+            r.free = group->nextFree;
+        }
+        else
+        {
+            group = new ThreadHistograms;
+            memset(group->histograms, 0, sizeof(group->histograms));
+            group->nextAll = r.all;
+            r.all = group;
+        }
+    }
+
+    tlsHistograms_ = group->histograms;
+    pthread_setspecific(key, group);
+    return group->histograms;
+}
+
+void Instrument::releaseThread(void* ptr)
+{
+    // 析构期间如果再有计时，会重新登记一组直方图
+    tlsHistograms_ = nullptr;
+
+    ThreadHistograms* group = static_cast<ThreadHistograms*>(ptr);
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    group->nextFree = r.free;
+    r.free = group;
+}
+
+void Instrument::merge(Histogram* out)
+{
+    memset(out, 0, sizeof(Histogram) * NUM_PROBES);
+
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (ThreadHistograms* group = r.all; group; group = group->nextAll)
+    {
+        for (int probe = 0; probe < NUM_PROBES; ++probe)
+        {
+            const Histogram& from = group->histograms[probe];
+            Histogram& to = out[probe];
+            for (int i = 0; i < NUM_BUCKETS; ++i)
+            {
+                to.buckets[i] += from.buckets[i];
+            }
+            to.count += from.count;
+            to.totalCycles += from.totalCycles;
+            to.maxCycles = std::max(to.maxCycles, from.maxCycles);
+        }
+    }
+}
+
+void Instrument::reset()
+{
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (ThreadHistograms* group = r.all; group; group = group->nextAll)
+    {
+        memset(group->histograms, 0, sizeof(group->histograms));
+    }
+}
+
+const char* Instrument::probeName(Probe probe)
+{
+    switch (probe)
+    {
+    case Probe::THREAD_CACHE_ALLOC:  return "thread_cache_alloc";
+    case Probe::THREAD_CACHE_FREE:   return "thread_cache_free";
+    case Probe::FETCH_FROM_CENTRAL:  return "fetch_from_central";
+    case Probe::CENTRAL_FETCH_WAIT:  return "central_fetch_wait";
+    case Probe::CENTRAL_FETCH_HOLD:  return "central_fetch_hold";
+    case Probe::CENTRAL_RETURN_WAIT: return "central_return_wait";
+    case Probe::CENTRAL_RETURN_HOLD: return "central_return_hold";
+    case Probe::PAGE_ALLOCATE_SPAN:  return "page_allocate_span";
+    case Probe::SYSTEM_ALLOC:        return "system_alloc";
+    default:                         return "unknown";
+    }
+}
+
+// 按计时点输出次数、平均/最大周期数、由直方图估算的分位数和非空的 log2 档
+void Instrument::dump(FILE* out)
+{
+    Histogram merged[NUM_PROBES];
+    merge(merged);
+
+    // 直方图档的上界作为分位数的估计
+    auto percentile = [](const Histogram& h, double p) -> uint64_t
+    {
+        uint64_t target = static_cast<uint64_t>(p * h.count);
+        uint64_t seen = 0;
+        for (int i = 0; i < NUM_BUCKETS; ++i)
+        {
+            seen += h.buckets[i];
+            if (seen > target) return i ? (uint64_t(1) << i) - 1 : 0;
+        }
+        return h.maxCycles;
+    };
+
+    fprintf(out, "%-20s %12s %10s %10s %10s %10s %12s\n",
+            "probe", "count", "mean", "p50<=", "p99<=", "p99.9<=", "max");
+    for (int probe = 0; probe < NUM_PROBES; ++probe)
+    {
+        const Histogram& h = merged[probe];
+        if (h.count == 0) continue;
+        fprintf(out, "%-20s %12lu %10lu %10lu %10lu %10lu %12lu\n",
+                probeName(static_cast<Probe>(probe)),
+                static_cast<unsigned long>(h.count),
+                static_cast<unsigned long>(h.totalCycles / h.count),
+                static_cast<unsigned long>(percentile(h, 0.50)),
+                static_cast<unsigned long>(percentile(h, 0.99)),
+                static_cast<unsigned long>(percentile(h, 0.999)),
+                static_cast<unsigned long>(h.maxCycles));
+    }
+
+    fprintf(out, "\n(cycles; ~%.2f cycles/ns)\n", countsPerNanosecond());
+    for (int probe = 0; probe < NUM_PROBES; ++probe)
+    {
+        const Histogram& h = merged[probe];
+        if (h.count == 0) continue;
+        fprintf(out, "%s:", probeName(static_cast<Probe>(probe)));
+        for (int i = 0; i < NUM_BUCKETS; ++i)
+        {
+            if (h.buckets[i])
+            {
+                fprintf(out, " <%lu:%lu", static_cast<unsigned long>(uint64_t(1) << i),
+                        static_cast<unsigned long>(h.buckets[i]));
+            }
+        }
+        fprintf(out, "\n");
+    }
+    fflush(out);
+}
+
+} // namespace memoryPool
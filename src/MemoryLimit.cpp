@@ -0,0 +1,222 @@
+#include "../include/MemoryLimit.h"
+#include "../include/CentralCache.h"
+#include "../include/PageCache.h"
+#include "../include/Numa.h"
+#include "../include/ThreadCache.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+namespace memoryPool
+{
+
+namespace
+{
+
+// 软压力的最短处理间隔
+constexpr uint64_t SOFT_RELIEVE_INTERVAL_NS = 100000000; // 100 毫秒
+
+// 回调及其参数
+std::mutex callbackMutex;
+PressureCallback pressureCallback = nullptr;
+void* pressureCallbackArg = nullptr;
+
+// 同一时刻只有一个线程处理压力；回调中再次进入慢速路径时不会重入
+std::mutex relieveMutex;
+uint64_t lastSoftRelieve = 0;
+
+// 后台监视线程；以指针保存，进程退出时仍在运行也不会在静态析构中终止进程
+std::mutex watcherMutex;
+std::condition_variable watcherCond;
+std::thread* watcherThread = nullptr;
+bool watcherStop = false;
+
+uint64_t monotonicNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 读取文件的第一行，失败时返回 false
+bool readLine(const std::string& path, char* line, size_t size)
+{
+    FILE* file = fopen(path.c_str(), "re");
+    if (!file) return false;
+    bool ok = fgets(line, static_cast<int>(size), file) != nullptr;
+    fclose(file);
+    return ok;
+}
+
+// 读取 cgroup 的字节数文件，"max" 或读取失败时返回 0
+uint64_t readBytes(const std::string& path)
+{
+    char line[64];
+    if (path.empty() || !readLine(path, line, sizeof(line))) return 0;
+    unsigned long long value = 0;
+    if (sscanf(line, "%llu", &value) != 1) return 0;
+    return value;
+}
+
+// 读取 PSI 文件中 some 和 full 行的 avg10
+void readPressure(const std::string& path, double& some, double& full)
+{
+    some = full = 0;
+    if (path.empty()) return;
+
+    FILE* file = fopen(path.c_str(), "re");
+    if (!file) return;
+
+    char line[256];
+    while (fgets(line, sizeof(line), file))
+    {
+        double value;
+        if (sscanf(line, "some avg10=%lf", &value) == 1) some = value;
+        else if (sscanf(line, "full avg10=%lf", &value) == 1) full = value;
+    }
+    fclose(file);
+}
+
+void watcherLoop(PressureWatcherConfig config)
+{
+    std::unique_lock<std::mutex> lock(watcherMutex);
+    while (!watcherStop)
+    {
+        lock.unlock();
+        MemoryPressure level = MemoryLimit::evaluate(config);
+        if (level != MemoryPressure::NONE) MemoryLimit::relieve(level);
+        lock.lock();
+
+        watcherCond.wait_for(lock, std::chrono::milliseconds(config.intervalMs),
+                             [] { return watcherStop; });
+    }
+}
+
+} // namespace
+
+// 设置限制
+void MemoryLimit::setLimits(size_t softBytes, size_t hardBytes)
+{
+    PageCache::getInstance().setLimits(softBytes, hardBytes);
+}
+
+// 设置压力回调
+void MemoryLimit::setCallback(PressureCallback callback, void* arg)
+{
+    std::lock_guard<std::mutex> lock(callbackMutex);
+    pressureCallback = callback;
+    pressureCallbackArg = arg;
+}
+
+// 立即归还缓存的内存
+size_t MemoryLimit::releaseFreeMemory()
+{
+    // 自上而下归还：线程缓存的内存块回到中心缓存，全空的 slab 回到页缓存，最后一并 madvise
+    ThreadCache::flushAllThreads();
+    size_t released = 0;
+    for (size_t node = 0; node < Numa::shardCount(); ++node)
+    {
+        Numa::centralCache(node).releaseEmptySpans();
+        released += Numa::pageCache(node).releaseFreeSpans();
+    }
+    return released;
+}
+
+// 处理一次压力
+size_t MemoryLimit::relieve(MemoryPressure level)
+{
+    if (level == MemoryPressure::NONE) return 0;
+
+    std::unique_lock<std::mutex> lock(relieveMutex, std::try_to_lock);
+    if (!lock.owns_lock()) return 0;
+
+    if (level == MemoryPressure::SOFT)
+    {
+        uint64_t now = monotonicNanos();
+        if (lastSoftRelieve && now - lastSoftRelieve < SOFT_RELIEVE_INTERVAL_NS) return 0;
+        lastSoftRelieve = now;
+    }
+
+    size_t released = releaseFreeMemory();
+
+    PressureCallback callback;
+    void* arg;
+    {
+        std::lock_guard<std::mutex> callbackLock(callbackMutex);
+        callback = pressureCallback;
+        arg = pressureCallbackArg;
+    }
+
+    // 回调释放的内存先回到当前线程缓存，再归还一次
+    if (callback)
+    {
+        callback(level, PageCache::getInstance().residentBytes(), arg);
+        released += releaseFreeMemory();
+    }
+    return released;
+}
+
+// 处理页缓存登记的压力
+void MemoryLimit::relievePending()
+{
+    relieve(PageCache::getInstance().takePressure());
+}
+
+// 分配失败后处理硬压力
+bool MemoryLimit::relieveAfterFailure()
+{
+    MemoryPressure level = PageCache::getInstance().takePressure();
+    if (level != MemoryPressure::HARD) return false;
+
+    relieve(level);
+    return true;
+}
+
+// 读取一次压力
+MemoryPressure MemoryLimit::evaluate(const PressureWatcherConfig& config)
+{
+    MemoryPressure level = MemoryPressure::NONE;
+
+    double some, full;
+    readPressure(config.pressurePath, some, full);
+    if (full >= config.fullThreshold && full > 0) return MemoryPressure::HARD;
+    if (some >= config.someThreshold && some > 0) level = MemoryPressure::SOFT;
+
+    uint64_t max = readBytes(config.maxPath);
+    if (max)
+    {
+        uint64_t current = readBytes(config.currentPath);
+        if (current >= max * config.hardRatio) return MemoryPressure::HARD;
+        if (current >= max * config.softRatio) level = MemoryPressure::SOFT;
+    }
+    return level;
+}
+
+// 启动后台监视线程
+void MemoryLimit::startWatcher(const PressureWatcherConfig& config)
+{
+    stopWatcher();
+
+    std::lock_guard<std::mutex> lock(watcherMutex);
+    watcherStop = false;
+    watcherThread = new std::thread(&watcherLoop, config);
+}
+
+// 停止后台监视线程
+void MemoryLimit::stopWatcher()
+{
+    std::thread* thread;
+    {
+        std::lock_guard<std::mutex> lock(watcherMutex);
+        if (!watcherThread) return;
+        thread = watcherThread;
+        watcherThread = nullptr;
+        watcherStop = true;
+    }
+    watcherCond.notify_all();
+    thread->join();
+    delete thread;
+}
+
+} // namespace memoryPool
@@ -0,0 +1,183 @@
+#include "../include/MemoryPool.h"
+#include "../include/CentralCache.h"
+#include "../include/PageCache.h"
+#include "../include/Numa.h"
+#include "../include/ThreadCache.h"
+
+namespace memoryPool
+{
+
+namespace
+{
+
+// 是否处于实时模式，以及进入前的衰减间隔（毫秒），退出时恢复
+bool realtimeActive = false;
+uint64_t savedDecayInterval = 0;
+
+} // namespace
+
+// 按大小类别索引展开
+void PoolStats::expandClasses()
+{
+    classes.resize(FREE_LIST_SIZE);
+    for (size_t index = 0; index < FREE_LIST_SIZE; ++index)
+    {
+        classes[index].size = (index + 1) * ALIGNMENT;
+    }
+}
+
+// 计算总量，并去掉没有任何活动的大小类别
+void PoolStats::compactClasses()
+{
+    size_t kept = 0;
+    for (const ClassStats& cls : classes)
+    {
+        threadCacheBytes += cls.threadCacheBytes;
+        internalFragmentation += cls.internalFragmentation;
+        if (cls.allocs > cls.frees)
+        {
+            liveBytes += (cls.allocs - cls.frees) * cls.size;
+        }
+
+        if (cls.allocs || cls.frees || cls.centralFreeBytes || cls.threadCacheBytes)
+        {
+            classes[kept++] = cls;
+        }
+    }
+    classes.resize(kept);
+    classes.shrink_to_fit();
+}
+
+// 汇总三层缓存的统计
+PoolStats MemoryPool::getStats()
+{
+    PoolStats stats;
+    stats.expandClasses();
+
+    // 开启过 NUMA 分片时汇总每个节点的页缓存和中心缓存
+    for (size_t node = 0; node < Numa::shardCount(); ++node)
+    {
+        Numa::pageCache(node).collectStats(stats);
+        Numa::centralCache(node).collectStats(stats);
+    }
+    ThreadCache::collectStats(stats);
+
+    stats.compactClasses();
+    return stats;
+}
+
+// 以可读格式输出统计
+void MemoryPool::dumpStats(FILE* out)
+{
+    PoolStats stats = getStats();
+
+    auto line = [out](size_t bytes, const char* what)
+    {
+        fprintf(out, "POOL: %15zu (%10.1f MiB) %s\n", bytes, bytes / 1048576.0, what);
+    };
+
+    fprintf(out, "------------------------------------------------\n");
+    line(stats.mappedBytes, "Bytes mapped from OS");
+    line(stats.residentBytes, "Bytes resident");
+    line(stats.releasedBytes, "Bytes released to OS");
+    line(stats.pageCacheFreeBytes, "Bytes in page cache free spans");
+    line(stats.centralCacheBytes, "Bytes in central cache");
+    line(stats.threadCacheBytes, "Bytes in thread caches");
+    line(stats.liveBytes, "Bytes in use by application");
+    line(stats.internalFragmentation, "Bytes lost to internal fragmentation");
+    fprintf(out, "POOL: %15zu              Thread caches\n", stats.threadCaches);
+    fprintf(out, "POOL: %15zu              Large allocations (live %zu)\n",
+            stats.largeAllocs, stats.largeAllocs - std::min(stats.largeAllocs, stats.largeFrees));
+    fprintf(out, "------------------------------------------------\n");
+
+    fprintf(out, "%8s %12s %12s %12s %12s %12s %12s\n",
+            "size", "allocs", "frees", "live", "central", "thread", "frag");
+    for (const ClassStats& cls : stats.classes)
+    {
+        size_t live = cls.allocs > cls.frees ? cls.allocs - cls.frees : 0;
+        fprintf(out, "%8zu %12zu %12zu %12zu %12zu %12zu %12zu\n",
+                cls.size, cls.allocs, cls.frees, live,
+                cls.centralFreeBytes, cls.threadCacheBytes, cls.internalFragmentation);
+    }
+    fflush(out);
+}
+
+// 为当前线程预留内存块
+bool MemoryPool::reserve(size_t size, size_t count)
+{
+    // 大对象不经过线程缓存
+    if (size > MAX_BYTES) return true;
+    size = size ? size : ALIGNMENT;
+
+    // 先在中心缓存切分出足够的空闲内存块，线程缓存取走其中最多 64 个，其余留在中心缓存
+    if (!Numa::currentCentral()->reserve(SizeClass::getIndex(size), count)) return false;
+    return ThreadCache::getInstance()->prefill(size, count);
+}
+
+// 按预热配置预留
+bool MemoryPool::prewarm(const PrewarmProfile& profile)
+{
+    bool ok = true;
+    for (const ClassReserve& cls : profile.classes)
+    {
+        ok = reserve(cls.size, cls.count) && ok;
+    }
+    return ok;
+}
+
+// 进入实时模式
+bool MemoryPool::enterRealtime(const RealtimeConfig& config)
+{
+    PageCache& pageCache = PageCache::getInstance();
+    CentralCache& centralCache = CentralCache::getInstance();
+
+    size_t numPages = (config.heapBytes + PageCache::PAGE_SIZE - 1) / PageCache::PAGE_SIZE;
+    if (!pageCache.reserve(numPages, config.lockMemory)) return false;
+
+    // 页表根节点和中心缓存的 slab 链表头是静态存储，首次写入某个大小类别时同样会缺页
+    if (!PageCache::prefaultPageMap(config.lockMemory) ||
+        !PageCache::prefault(&centralCache, sizeof(CentralCache), config.lockMemory))
+    {
+        return false;
+    }
+
+    // 先关闭增长，预先填充只能使用固定堆；固定堆不够时立即失败
+    pageCache.setGrowthEnabled(false);
+    if (!realtimeActive) savedDecayInterval = ThreadCache::decayInterval();
+    realtimeActive = true;
+    ThreadCache::setDecayInterval(0);
+    ThreadCache::setFixedHeap(true);
+
+    if (!prepareRealtimeThread(config))
+    {
+        exitRealtime();
+        return false;
+    }
+    return true;
+}
+
+// 准备实时线程
+bool MemoryPool::prepareRealtimeThread(const RealtimeConfig& config)
+{
+    ThreadCache* cache = ThreadCache::getInstance();
+    if (!cache->prefault(config.lockMemory)) return false;
+
+    for (const ClassReserve& cls : config.classes)
+    {
+        if (!reserve(cls.size, cls.count)) return false;
+    }
+    return true;
+}
+
+// 退出实时模式
+void MemoryPool::exitRealtime()
+{
+    if (!realtimeActive) return;
+    realtimeActive = false;
+
+    PageCache::getInstance().setGrowthEnabled(true);
+    ThreadCache::setDecayInterval(savedDecayInterval);
+    ThreadCache::setFixedHeap(false);
+}
+
+} // namespace memoryPool
@@ -0,0 +1,121 @@
+// 可选的全局 operator new/delete 替换
+// 该文件不属于 memory_pool 库本身，链接 memory_pool_newdelete 目标即可让程序中所有 new/delete 走内存池。
+// 带大小的 delete 直接进入 ThreadCache::deallocate(ptr, size) 快速路径，不查页表；
+// 不带大小的 delete 通过页表查询内存块大小。
+#include "../include/MemoryPool.h"
+#include <new>
+
+using namespace memoryPool;
+
+namespace
+{
+
+// 按标准语义循环调用 new_handler，直到分配成功或没有 handler 可用
+void* poolNew(size_t size)
+{
+    for (;;)
+    {
+        void* ptr = MemoryPool::allocate(size);
+        if (ptr) return ptr;
+
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* poolNew(size_t size, std::align_val_t alignment)
+{
+    for (;;)
+    {
+        void* ptr = MemoryPool::allocate(size, static_cast<size_t>(alignment));
+        if (ptr) return ptr;
+
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* poolNewNothrow(size_t size) noexcept
+{
+    try
+    {
+        return poolNew(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void* poolNewNothrow(size_t size, std::align_val_t alignment) noexcept
+{
+    try
+    {
+        return poolNew(size, alignment);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void poolDelete(void* ptr) noexcept
+{
+    MemoryPool::deallocate(ptr);
+}
+
+void poolDelete(void* ptr, size_t size) noexcept
+{
+    if (ptr) MemoryPool::deallocate(ptr, size);
+}
+
+void poolDelete(void* ptr, size_t size, std::align_val_t alignment) noexcept
+{
+    if (ptr) MemoryPool::deallocate(ptr, size, static_cast<size_t>(alignment));
+}
+
+} // namespace
+
+// 普通版本
+void* operator new(size_t size) { return poolNew(size); }
+void* operator new[](size_t size) { return poolNew(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return poolNewNothrow(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return poolNewNothrow(size); }
+
+void operator delete(void* ptr) noexcept { poolDelete(ptr); }
+void operator delete[](void* ptr) noexcept { poolDelete(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { poolDelete(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { poolDelete(ptr); }
+
+// C++14 带大小的 delete
+void operator delete(void* ptr, size_t size) noexcept { poolDelete(ptr, size); }
+void operator delete[](void* ptr, size_t size) noexcept { poolDelete(ptr, size); }
+
+// C++17 对齐版本
+void* operator new(size_t size, std::align_val_t alignment) { return poolNew(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return poolNew(size, alignment); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return poolNewNothrow(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return poolNewNothrow(size, alignment);
+}
+
+// 不带大小的对齐 delete 无法得知对齐方式，统一按页表查询
+void operator delete(void* ptr, std::align_val_t) noexcept { poolDelete(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { poolDelete(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { poolDelete(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { poolDelete(ptr); }
+
+void operator delete(void* ptr, size_t size, std::align_val_t alignment) noexcept
+{
+    poolDelete(ptr, size, alignment);
+}
+void operator delete[](void* ptr, size_t size, std::align_val_t alignment) noexcept
+{
+    poolDelete(ptr, size, alignment);
+}
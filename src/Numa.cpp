@@ -0,0 +1,136 @@
+#include "../include/Numa.h"
+#include "../include/CentralCache.h"
+#include "../include/PageCache.h"
+#include <cstdio>
+#include <new>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// 来自 <linux/mempolicy.h>，不引入内核头文件
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
+namespace memoryPool
+{
+
+namespace
+{
+
+// 分片的元数据较大（中心缓存按大小类别展开），与独立堆一样直接用 mmap 分配
+void* mapMemory(size_t size)
+{
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) throw std::bad_alloc();
+    return memory;
+}
+
+} // namespace
+
+// 读取在线节点列表（如 "0-1" 或 "0,2-3"），节点数取最大编号加一
+SystemNumaTopology::SystemNumaTopology() : nodes_(1)
+{
+    FILE* file = fopen("/sys/devices/system/node/online", "re");
+    if (!file) return;
+
+    char line[256];
+    if (fgets(line, sizeof(line), file))
+    {
+        size_t maxNode = 0;
+        for (const char* p = line; *p;)
+        {
+            if (*p >= '0' && *p <= '9')
+            {
+                size_t node = 0;
+                while (*p >= '0' && *p <= '9') node = node * 10 + (*p++ - '0');
+                maxNode = std::max(maxNode, node);
+            }
+            else
+            {
+                ++p;
+            }
+        }
+        nodes_ = std::min(maxNode + 1, Numa::MAX_NODES);
+    }
+    fclose(file);
+}
+
+size_t SystemNumaTopology::currentNode() const
+{
+    // glibc 的 getcpu 经由 vDSO，不进入内核
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (getcpu(&cpu, &node) != 0) return 0;
+    return node;
+}
+
+bool SystemNumaTopology::bind(void* addr, size_t bytes, size_t node) const
+{
+    unsigned long mask = 1UL << node;
+    // maxnode 按内核的约定比位图的位数多 1
+    return syscall(SYS_mbind, addr, bytes, MPOL_PREFERRED, &mask, Numa::MAX_NODES + 1, 0) == 0;
+}
+
+// 开启 NUMA 分片
+bool Numa::enable(const NumaTopology* topology)
+{
+    if (!topology) topology = &SystemNumaTopology::getInstance();
+    size_t nodes = std::min(topology->nodeCount(), MAX_NODES);
+    if (nodes <= 1) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // 按需创建缺少的分片，已创建的沿用
+    size_t shards = shards_.load(std::memory_order_relaxed);
+    for (size_t node = shards; node < nodes; ++node)
+    {
+        PageCache* pageCache = new (mapMemory(sizeof(PageCache))) PageCache;
+        pageCaches_[node] = pageCache;
+        centralCaches_[node] = new (mapMemory(sizeof(CentralCache))) CentralCache(*pageCache);
+    }
+    if (nodes > shards) shards_.store(nodes, std::memory_order_release);
+
+    for (size_t node = 0; node < nodes; ++node)
+    {
+        pageCache(node).setNode(topology, node);
+    }
+
+    topology_.store(topology, std::memory_order_release);
+    nodes_.store(nodes, std::memory_order_release);
+    enabled_.store(true, std::memory_order_release);
+    return true;
+}
+
+// 关闭 NUMA 分片
+void Numa::disable()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_.store(false, std::memory_order_release);
+
+    // 全局页缓存恢复默认的首次访问放置；其他分片只在仍持有其中心缓存的线程补充时增长，保持绑定
+    PageCache::getInstance().setNode(nullptr, 0);
+}
+
+// 调用线程应当使用的中心缓存
+CentralCache* Numa::currentCentral()
+{
+    if (!enabled()) return &CentralCache::getInstance();
+
+    size_t node = topology_.load(std::memory_order_acquire)->currentNode();
+    if (node >= nodes_.load(std::memory_order_acquire)) node = 0;
+    return &centralCache(node);
+}
+
+PageCache& Numa::pageCache(size_t node)
+{
+    return node == 0 ? PageCache::getInstance() : *pageCaches_[node];
+}
+
+CentralCache& Numa::centralCache(size_t node)
+{
+    return node == 0 ? CentralCache::getInstance() : *centralCaches_[node];
+}
+
+} // namespace memoryPool
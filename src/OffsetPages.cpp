@@ -0,0 +1,107 @@
+#include "../include/OffsetPages.h"
+#include "../include/PageCache.h"
+
+namespace memoryPool
+{
+
+namespace
+{
+
+constexpr size_t PAGE_SIZE = PageCache::PAGE_SIZE;
+
+// 空闲页段链表的节点
+struct FreeRun
+{
+    uint64_t next;     // 下一个空闲页段的偏移，按地址递增
+    uint64_t numPages;
+};
+
+FreeRun* runAt(char* base, uint64_t offset)
+{
+    return reinterpret_cast<FreeRun*>(base + offset);
+}
+
+} // namespace
+
+// 分配页段
+uint64_t OffsetPages::allocate(char* base, size_t numPages)
+{
+    // 首次适配：从页段开头切出，剩余部分留在原位置，链表仍按地址有序
+    for (uint64_t* link = &freeRuns; *link; link = &runAt(base, *link)->next)
+    {
+        FreeRun* run = runAt(base, *link);
+        if (run->numPages < numPages) continue;
+
+        uint64_t offset = *link;
+        if (run->numPages == numPages)
+        {
+            *link = run->next;
+        }
+        else
+        {
+            uint64_t rest = offset + numPages * PAGE_SIZE;
+            FreeRun* remaining = runAt(base, rest);
+            remaining->next = run->next;
+            remaining->numPages = run->numPages - numPages;
+            *link = rest;
+        }
+        return offset;
+    }
+
+    // 从未使用区域切分
+    if (numPages > (limit - top) / PAGE_SIZE) return 0;
+    uint64_t offset = top;
+    top += numPages * PAGE_SIZE;
+    return offset;
+}
+
+// 归还页段
+void OffsetPages::free(char* base, uint64_t offset, size_t numPages)
+{
+    // 找到插入位置：prevLink 指向前一个页段的偏移，link 指向后一个页段的偏移
+    uint64_t* prevLink = nullptr;
+    uint64_t* link = &freeRuns;
+    while (*link && *link < offset)
+    {
+        prevLink = link;
+        link = &runAt(base, *link)->next;
+    }
+
+    // 与前后相邻的空闲页段合并
+    FreeRun* prev = prevLink ? runAt(base, *prevLink) : nullptr;
+    bool mergePrev = prev && *prevLink + prev->numPages * PAGE_SIZE == offset;
+    uint64_t start = mergePrev ? *prevLink : offset;
+    size_t pages = (mergePrev ? prev->numPages : 0) + numPages;
+
+    uint64_t next = *link;
+    if (next && next == offset + numPages * PAGE_SIZE)
+    {
+        FreeRun* nextRun = runAt(base, next);
+        pages += nextRun->numPages;
+        next = nextRun->next;
+    }
+
+    // 紧邻未使用区域时整段并入，不留在链表中
+    if (start + pages * PAGE_SIZE == top)
+    {
+        top = start;
+        if (mergePrev) *prevLink = next;
+        else *link = next;
+        return;
+    }
+
+    if (mergePrev)
+    {
+        prev->numPages = pages;
+        prev->next = next;
+    }
+    else
+    {
+        FreeRun* run = runAt(base, offset);
+        run->numPages = pages;
+        run->next = next;
+        *link = offset;
+    }
+}
+
+} // namespace memoryPool
@@ -1,133 +1,534 @@
 #include "PageCache.h"
+#include "Instrument.h"
+#include "Numa.h"
 #include <sys/mman.h> // 用于 mmap 系统调用
+#include <sched.h>    // 用于 sched_getcpu
 #include <cstring>    // 用于 memset
+#include <algorithm>  // 用于 std::sort
 
 namespace memoryPool
 {
 
+// 选择请求所在的分片
+size_t PageCache::shardFor(size_t objSize)
+{
+    // 切分 slab 的请求按大小类别：不同类别落在不同分片，同一类别的补充集中在同一分片
+    if (objSize && objSize <= MAX_BYTES) return SizeClass::getIndex(objSize) % SHARDS;
+
+    // 大对象和不切分的 span 按当前 CPU
+    int cpu = sched_getcpu();
+    return cpu < 0 ? 0 : static_cast<size_t>(cpu) % SHARDS;
+}
+
 // 分配指定页数的内存块（span）
-void* PageCache::allocateSpan(size_t numPages)
+void* PageCache::allocateSpan(size_t numPages, size_t objSize)
 {
-    // 加锁，确保线程安全
-    std::lock_guard<std::mutex> lock(mutex_);
+    MEMORY_POOL_PROBE_SCOPE(PAGE_ALLOCATE_SPAN);
 
-    // 在 freeSpans_ 中查找第一个页数大于等于 numPages 的空闲 Span
-    auto it = freeSpans_.lower_bound(numPages);
-    if (it != freeSpans_.end()) // 找到合适的空闲 Span
+    // 先在所选分片中查找，再依次回退到其他分片；空闲页数不足的分片不加锁直接跳过
+    size_t home = shardFor(objSize);
+    for (size_t i = 0; i < SHARDS; ++i)
     {
-        Span* span = it->second; // 获取链表头部的 Span
+        size_t index = (home + i) % SHARDS;
+        if (shards_[index].freePages.load(std::memory_order_relaxed) < numPages) continue;
 
-        // 将该 Span 从空闲链表中移除
-        if (span->next)
-        {
-            freeSpans_[it->first] = span->next; // 更新链表头
-        }
-        else
-        {
-            freeSpans_.erase(it); // 如果是最后一个 Span，删除该条目
-        }
+        bool rejected = false;
+        void* memory = allocateFromShard(index, numPages, objSize, rejected);
+        if (memory) return memory;
+        if (rejected) return nullptr;
+    }
 
-        // 如果 Span 页数大于请求的 numPages，进行分割
-        if (span->numPages > numPages)
-        {
-            // 创建新 Span 表示多余的部分
-            Span* newSpan = new Span;
-            newSpan->pageAddr = static_cast<char*>(span->pageAddr) + numPages * PAGE_SIZE; // 计算新 Span 的起始地址
-            newSpan->numPages = span->numPages - numPages; // 计算剩余页数
-            newSpan->next = nullptr;
-
-            // 将多余部分插入到对应的空闲链表头部
-            auto& list = freeSpans_[newSpan->numPages];
-            newSpan->next = list;
-            list = newSpan;
-
-            // 更新当前 Span 的页数为请求的页数
-            span->numPages = numPages;
-        }
+    // 没有合适的空闲 Span，向系统申请新内存；不允许增长时立即失败
+    if (!growthEnabled_.load(std::memory_order_relaxed)) return nullptr;
+    size_t bytes = numPages * PAGE_SIZE;
+    if (!admitResident(bytes)) return nullptr;
 
-        // 记录分配的 Span 到 spanMap_，便于回收
-        spanMap_[span->pageAddr] = span;
-        return span->pageAddr; // 返回内存块地址
-    }
+    // 先计入映射字节数，使并发的分配看到这部分驻留
+    mappedBytes_.fetch_add(bytes, std::memory_order_relaxed);
 
-    // 没有合适的空闲 Span，向系统申请新内存
+    // mmap 与清零不持有任何锁
     void* memory = systemAlloc(numPages);
-    if (!memory) return nullptr; // 分配失败返回空指针
+    if (!memory) // 分配失败返回空指针
+    {
+        mappedBytes_.fetch_sub(bytes, std::memory_order_relaxed);
+        return nullptr;
+    }
 
     // 创建新的 Span 对象
     Span* span = new Span;
     span->pageAddr = memory;
     span->numPages = numPages;
+    span->objSize = objSize;
     span->next = nullptr;
+    span->shard = home;
+
+    // 记录新 Span 到页表；这段内存尚未交给任何人，登记无需加锁
+    if (!pageMap().setRange(pageIdOf(memory), numPages, span))
+    {
+        pageMap().setRange(pageIdOf(memory), numPages, nullptr);
+        munmap(memory, bytes);
+        mappedBytes_.fetch_sub(bytes, std::memory_order_relaxed);
+        delete span;
+        return nullptr;
+    }
 
-    // 记录新 Span 到 spanMap_
-    spanMap_[memory] = span;
+    std::lock_guard<std::mutex> lock(shards_[home].mutex);
+    shards_[home].regions.emplace(memory, numPages);
     return memory; // 返回新分配的内存地址
 }
 
+// 从指定分片取出空闲 span
+void* PageCache::allocateFromShard(size_t shardIndex, size_t numPages, size_t objSize, bool& rejected)
+{
+    Shard& shard = shards_[shardIndex];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    // 在 freeSpans 中查找第一个页数大于等于 numPages 的空闲 Span
+    auto it = shard.freeSpans.lower_bound(numPages);
+    if (it == shard.freeSpans.end()) return nullptr;
+
+    Span* span = it->second; // 获取链表头部的 Span
+
+    // 复用已归还给操作系统的页会使其重新驻留，同样受限制约束
+    if (span->released && !admitResident(numPages * PAGE_SIZE))
+    {
+        rejected = true;
+        return nullptr;
+    }
+
+    // 将该 Span 从空闲链表中移除
+    if (span->next)
+    {
+        it->second = span->next; // 更新链表头
+    }
+    else
+    {
+        shard.freeSpans.erase(it); // 如果是最后一个 Span，删除该条目
+    }
+    span->next = nullptr;
+    shard.freePages.fetch_sub(span->numPages, std::memory_order_relaxed);
+
+    // 如果 Span 页数大于请求的 numPages，进行分割
+    if (span->numPages > numPages)
+    {
+        // 创建新 Span 表示多余的部分，留在同一分片
+        Span* newSpan = new Span;
+        newSpan->pageAddr = static_cast<char*>(span->pageAddr) + numPages * PAGE_SIZE; // 计算新 Span 的起始地址
+        newSpan->numPages = span->numPages - numPages; // 计算剩余页数
+        newSpan->next = nullptr;
+
+        newSpan->objSize = 0;
+        newSpan->released = span->released;
+        newSpan->shard = shardIndex;
+
+        // 更新当前 Span 的页数为请求的页数
+        span->numPages = numPages;
+
+        // 在页表中登记多余部分，便于回收时合并
+        pageMap().setRange(pageIdOf(newSpan->pageAddr), newSpan->numPages, newSpan);
+
+        // 将多余部分插入到对应的空闲链表头部
+        pushFree(shard, newSpan);
+    }
+
+    if (span->released)
+    {
+        releasedBytes_.fetch_sub(numPages * PAGE_SIZE, std::memory_order_relaxed);
+        span->released = false;
+    }
+
+    // 记录分配的 Span 到页表，便于回收和按指针查询大小
+    span->objSize = objSize;
+    span->owner.store(nullptr, std::memory_order_relaxed);
+    pageMap().setRange(pageIdOf(span->pageAddr), span->numPages, span);
+    return span->pageAddr; // 返回内存块地址
+}
+
 // 释放指定的内存块（span）
 void PageCache::deallocateSpan(void* ptr, size_t numPages)
 {
-    // 加锁，确保线程安全
-    std::lock_guard<std::mutex> lock(mutex_);
+    // 在页表中查找对应的 Span；span 仍由调用者持有，无锁读取其所属分片是安全的
+    Span* span = pageMap().get(pageIdOf(ptr));
+    if (!span || span->pageAddr != ptr) return; // 未找到，说明不是 PageCache 分配的，直接返回
 
-    // 在 spanMap_ 中查找对应的 Span
-    auto it = spanMap_.find(ptr);
-    if (it == spanMap_.end()) return; // 未找到，说明不是 PageCache 分配的，直接返回
+    // 加锁，确保线程安全
+    Shard& shard = shards_[span->shard];
+    std::lock_guard<std::mutex> lock(shard.mutex);
 
-    Span* span = it->second; // 获取对应的 Span 对象
+    span->objSize = 0; // 标记为未切分
 
     // 尝试与下一个相邻的 Span 合并
     void* nextAddr = static_cast<char*>(ptr) + numPages * PAGE_SIZE; // 计算下一个 Span 的起始地址
-    auto nextIt = spanMap_.find(nextAddr);
 
-    if (nextIt != spanMap_.end()) // 如果下一个地址存在于 spanMap_ 中
+    // 下一页属于其他分片（或其他页缓存）时，其 Span 可能正被另一把锁下的合并删除，不能访问
+    Span* nextSpan = ownsPage(shard, nextAddr) ? pageMap().get(pageIdOf(nextAddr)) : nullptr;
+
+    if (nextSpan && nextSpan->pageAddr == nextAddr) // 如果下一个地址是某个 Span 的起始地址
     {
-        Span* nextSpan = nextIt->second; // 获取相邻的 Span
+        // 如果 nextSpan 是空闲的，进行合并
+        if (eraseFree(shard, nextSpan))
+        {
+            // 合并后的 span 整体按驻留计算，下次归还时再一并 madvise
+            if (nextSpan->released)
+            {
+                releasedBytes_.fetch_sub(nextSpan->numPages * PAGE_SIZE, std::memory_order_relaxed);
+            }
+            span->numPages += nextSpan->numPages; // 增加当前 Span 的页数
+            // 将 nextSpan 的页改为指向合并后的 Span
+            pageMap().setRange(pageIdOf(nextAddr), nextSpan->numPages, span);
+            delete nextSpan; // 删除合并的 Span 对象
+        }
+    }
 
-        // 检查 nextSpan 是否在空闲链表中
-        bool found = false;
-        auto& nextList = freeSpans_[nextSpan->numPages];
+    // 将当前 Span（可能已合并）插入到空闲链表头部
+    pushFree(shard, span);
+}
 
-        // 如果 nextSpan 是链表头
-        if (nextList == nextSpan)
+// 插入空闲链表头部
+void PageCache::pushFree(Shard& shard, Span* span)
+{
+    auto& list = shard.freeSpans[span->numPages];
+    span->next = list;
+    list = span;
+    shard.freePages.fetch_add(span->numPages, std::memory_order_relaxed);
+}
+
+// 从空闲链表中移除，span 不在链表中时返回 false
+bool PageCache::eraseFree(Shard& shard, Span* span)
+{
+    // 使用 find 而不是 operator[]，避免插入空链表头导致 allocateFromShard 取到空指针
+    auto listIt = shard.freeSpans.find(span->numPages);
+    if (listIt == shard.freeSpans.end()) return false;
+
+    bool found = false;
+    Span*& list = listIt->second;
+
+    // 如果 span 是链表头
+    if (list == span)
+    {
+        list = span->next; // 更新链表头
+        found = true;
+    }
+    else // 遍历查找
+    {
+        for (Span* prev = list; prev->next; prev = prev->next)
         {
-            nextList = nextSpan->next; // 更新链表头
-            found = true;
+            if (prev->next == span)
+            {
+                prev->next = span->next; // 从链表中移除 span
+                found = true;
+                break;
+            }
+        }
+    }
+
+    if (!list) shard.freeSpans.erase(listIt); // 链表已空，删除该条目
+    if (found) shard.freePages.fetch_sub(span->numPages, std::memory_order_relaxed);
+    return found;
+}
+
+// 判断地址是否位于分片映射的某一段内
+bool PageCache::ownsPage(const Shard& shard, void* addr)
+{
+    auto it = shard.regions.upper_bound(addr);
+    if (it == shard.regions.begin()) return false;
+    --it;
+    return static_cast<char*>(addr) < static_cast<char*>(it->first) + it->second * PAGE_SIZE;
+}
+
+// 归还全部内存
+void PageCache::releaseAll()
+{
+    // 按分片顺序加锁，所有跨分片的操作都按同一顺序，不会死锁
+    std::unique_lock<std::mutex> locks[SHARDS];
+    for (size_t i = 0; i < SHARDS; ++i)
+    {
+        locks[i] = std::unique_lock<std::mutex>(shards_[i].mutex);
+    }
+
+    // 同一分片相邻的两段映射中的空闲 span 可能已被合并成跨段的一个，按地址顺序遍历才能只删除一次
+    std::vector<std::pair<void*, size_t>, SystemAllocator<std::pair<void*, size_t>>> regions;
+    for (const Shard& shard : shards_)
+    {
+        regions.insert(regions.end(), shard.regions.begin(), shard.regions.end());
+    }
+    std::sort(regions.begin(), regions.end());
+
+    std::vector<Span*, SystemAllocator<Span*>> spans;
+    for (const auto& region : regions)
+    {
+        char* addr = static_cast<char*>(region.first);
+        char* end = addr + region.second * PAGE_SIZE;
+        while (addr < end)
+        {
+            Span* span = pageMap().get(pageIdOf(addr));
+            char* spanEnd = static_cast<char*>(span->pageAddr) + span->numPages * PAGE_SIZE;
+            if (span->pageAddr == addr) spans.push_back(span);
+            addr = spanEnd; // 跨段 span 的后半部分直接跳过
         }
-        else if (nextList) // 如果链表非空，遍历查找
+    }
+
+    for (const auto& region : regions)
+    {
+        pageMap().setRange(pageIdOf(region.first), region.second, nullptr);
+        munmap(region.first, region.second * PAGE_SIZE);
+    }
+    for (Span* span : spans)
+    {
+        delete span;
+    }
+
+    for (Shard& shard : shards_)
+    {
+        shard.regions.clear();
+        shard.freeSpans.clear();
+        shard.freePages.store(0, std::memory_order_relaxed);
+    }
+    mappedBytes_.store(0, std::memory_order_relaxed);
+    releasedBytes_.store(0, std::memory_order_relaxed);
+}
+
+// 预留固定的堆
+bool PageCache::reserve(size_t numPages, bool lockMemory)
+{
+    if (numPages == 0) return true;
+    size_t size = numPages * PAGE_SIZE;
+
+    // MAP_POPULATE 在映射时就为全部页分配物理内存并建立页表项，之后访问不会缺页；
+    // 这段内存不经过 systemAlloc，内核保证其已清零
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (memory == MAP_FAILED) return false;
+    if (lockMemory && mlock(memory, size) != 0)
+    {
+        munmap(memory, size);
+        return false;
+    }
+
+    // 整段放入当前 CPU 的分片，其他分片的请求通过回退取用
+    size_t index = shardFor(0);
+
+    Span* span = new Span;
+    span->pageAddr = memory;
+    span->numPages = numPages;
+    span->objSize = 0;
+    span->next = nullptr;
+    span->shard = index;
+
+    // 整段登记到页表：页表叶子节点在这里分配并写入，之后在这段内存中分割 span 不会再分配叶子节点
+    if (!pageMap().setRange(pageIdOf(memory), numPages, span))
+    {
+        pageMap().setRange(pageIdOf(memory), numPages, nullptr);
+        munmap(memory, size);
+        delete span;
+        return false;
+    }
+
+    mappedBytes_.fetch_add(size, std::memory_order_relaxed);
+
+    Shard& shard = shards_[index];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.regions.emplace(memory, numPages);
+    pushFree(shard, span);
+    return true;
+}
+
+// 设置是否允许向操作系统申请新内存
+void PageCache::setGrowthEnabled(bool enabled)
+{
+    growthEnabled_.store(enabled, std::memory_order_relaxed);
+}
+
+// 设置所属的 NUMA 节点
+void PageCache::setNode(const NumaTopology* topology, size_t node)
+{
+    node_.store(node, std::memory_order_relaxed);
+    topology_.store(topology, std::memory_order_release);
+}
+
+// 设置驻留字节数的限制
+void PageCache::setLimits(size_t softBytes, size_t hardBytes)
+{
+    softLimit_.store(softBytes, std::memory_order_relaxed);
+    hardLimit_.store(hardBytes, std::memory_order_relaxed);
+    if (!softBytes && !hardBytes) pressure_.store(MemoryPressure::NONE, std::memory_order_relaxed);
+}
+
+// 检查新增驻留是否超过限制
+bool PageCache::admitResident(size_t bytes)
+{
+    size_t hardLimit = hardLimit_.load(std::memory_order_relaxed);
+    size_t softLimit = softLimit_.load(std::memory_order_relaxed);
+    if (!hardLimit && !softLimit) return true;
+
+    size_t resident = residentBytes() + bytes;
+    if (hardLimit && resident > hardLimit)
+    {
+        pressure_.store(MemoryPressure::HARD, std::memory_order_relaxed);
+        return false;
+    }
+    if (softLimit && resident > softLimit)
+    {
+        // 不覆盖尚未处理的硬压力
+        MemoryPressure expected = MemoryPressure::NONE;
+        pressure_.compare_exchange_strong(expected, MemoryPressure::SOFT, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+// 把空闲 span 归还给操作系统
+size_t PageCache::releaseFreeSpans()
+{
+    if (!growthEnabled_.load(std::memory_order_relaxed)) return 0;
+
+    size_t released = 0;
+    std::vector<Span*, SystemAllocator<Span*>> spans;
+    for (Shard& shard : shards_)
+    {
+        // 持锁摘下尚未归还的空闲 span：摘下后不会被分配或合并，madvise 期间无需持锁
+        spans.clear();
         {
-            Span* prev = nextList;
-            while (prev->next)
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            size_t count = 0;
+            for (const auto& entry : shard.freeSpans)
+            {
+                for (const Span* span = entry.second; span; span = span->next) count += !span->released;
+            }
+            spans.reserve(count);
+
+            for (auto it = shard.freeSpans.begin(); it != shard.freeSpans.end();)
             {
-                if (prev->next == nextSpan)
+                Span** link = &it->second;
+                while (Span* span = *link)
                 {
-                    prev->next = nextSpan->next; // 从链表中移除 nextSpan
-                    found = true;
-                    break;
+                    if (span->released)
+                    {
+                        link = &span->next;
+                        continue;
+                    }
+                    *link = span->next;
+                    span->next = nullptr;
+                    shard.freePages.fetch_sub(span->numPages, std::memory_order_relaxed);
+                    spans.push_back(span);
                 }
-                prev = prev->next;
+                it = it->second ? std::next(it) : shard.freeSpans.erase(it);
             }
         }
+        if (spans.empty()) continue;
 
-        // 如果 nextSpan 是空闲的，进行合并
-        if (found)
+        size_t shardReleased = 0;
+        for (Span* span : spans)
         {
-            span->numPages += nextSpan->numPages; // 增加当前 Span 的页数
-            spanMap_.erase(nextAddr); // 从 spanMap_ 中移除 nextSpan
-            delete nextSpan; // 删除合并的 Span 对象
+            // 被 mlock 锁定的页无法归还，跳过
+            size_t bytes = span->numPages * PAGE_SIZE;
+            if (madvise(span->pageAddr, bytes, MADV_DONTNEED) != 0) continue;
+            span->released = true;
+            shardReleased += bytes;
         }
+
+        // 先计入归还的字节数，再放回链表，之后的复用才能正确扣减
+        releasedBytes_.fetch_add(shardReleased, std::memory_order_relaxed);
+        released += shardReleased;
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (Span* span : spans) pushFree(shard, span);
     }
+    return released;
+}
 
-    // 将当前 Span（可能已合并）插入到空闲链表头部
-    auto& list = freeSpans_[span->numPages];
-    span->next = list;
-    list = span;
+// 驻留字节数
+size_t PageCache::residentBytes()
+{
+    size_t mapped = mappedBytes_.load(std::memory_order_relaxed);
+    size_t released = releasedBytes_.load(std::memory_order_relaxed);
+    // 两个计数分别读取，并发更新时可能短暂出现归还多于映射
+    return mapped > released ? mapped - released : 0;
+}
+
+// 为一段已映射的元数据预先建立页表项
+bool PageCache::prefault(const void* addr, size_t bytes, bool lockMemory)
+{
+    // 扩展到整页
+    uintptr_t begin = reinterpret_cast<uintptr_t>(addr) & ~(PAGE_SIZE - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(addr) + bytes + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    void* start = reinterpret_cast<void*>(begin);
+    size_t length = end - begin;
+
+    // MADV_POPULATE_WRITE 按写访问建立页表项而不改变内容（Linux 5.14 起）；
+    // 不支持时退回 mlock，它同样会让全部页驻留
+    bool populated = false;
+#ifdef MADV_POPULATE_WRITE
+    populated = madvise(start, length, MADV_POPULATE_WRITE) == 0;
+#endif
+    if (!populated || lockMemory)
+    {
+        return mlock(start, length) == 0;
+    }
+    return true;
+}
+
+// 汇总页缓存的统计
+void PageCache::collectStats(PoolStats& stats)
+{
+    size_t mapped = mappedBytes_.load(std::memory_order_relaxed);
+    size_t released = releasedBytes_.load(std::memory_order_relaxed);
+    stats.mappedBytes += mapped;
+    stats.releasedBytes += released;
+    stats.residentBytes += mapped > released ? mapped - released : 0;
+
+    for (Shard& shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& entry : shard.freeSpans)
+        {
+            for (const Span* span = entry.second; span; span = span->next)
+            {
+                stats.pageCacheFreeBytes += span->numPages * PAGE_SIZE;
+            }
+        }
+    }
+}
+
+// 查询指针所在内存块的大小
+size_t PageCache::getObjectSize(void* ptr)
+{
+    Span* span = pageMap().get(pageIdOf(ptr));
+    return span ? span->objSize : 0;
+}
+
+// 查询指针所在 span 的所属者
+void* PageCache::getSpanOwner(void* ptr)
+{
+    Span* span = pageMap().get(pageIdOf(ptr));
+    return span ? span->owner.load(std::memory_order_acquire) : nullptr;
+}
+
+// 为链表中各内存块所在的 span 设置所属者（已有所属者的不变）
+void PageCache::claimSpanOwners(void* start, void* owner)
+{
+    // 中心缓存按 slab 依次切出内存块，同一 span 的内存块在链表中通常相邻，只在进入新 span 时查询页表
+    Span* span = nullptr;
+    for (void* current = start; current; current = *reinterpret_cast<void**>(current))
+    {
+        if (span && current >= span->pageAddr &&
+            current < static_cast<char*>(span->pageAddr) + span->numPages * PAGE_SIZE)
+        {
+            continue;
+        }
+
+        span = pageMap().get(pageIdOf(current));
+        if (!span) continue;
+
+        void* expected = nullptr;
+        span->owner.compare_exchange_strong(expected, owner, std::memory_order_acq_rel);
+    }
 }
 
 // 向操作系统申请指定页数的内存
 void* PageCache::systemAlloc(size_t numPages)
 {
+    MEMORY_POOL_PROBE_SCOPE(SYSTEM_ALLOC);
+
     size_t size = numPages * PAGE_SIZE; // 计算需要的总字节数
 
     // 使用 mmap 分配匿名私有内存
@@ -135,6 +536,10 @@ void* PageCache::systemAlloc(size_t numPages)
                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
     if (ptr == MAP_FAILED) return nullptr; // 分配失败返回空指针
 
+    // NUMA 分片：在首次写入之前绑定，下面的清零即在目标节点上分配物理页
+    const NumaTopology* topology = topology_.load(std::memory_order_acquire);
+    if (topology) topology->bind(ptr, size, node_.load(std::memory_order_relaxed));
+
     // 将分配的内存清零
     memset(ptr, 0, size);
     return ptr; // 返回分配的内存地址
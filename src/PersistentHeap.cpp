@@ -0,0 +1,255 @@
+#include "../include/PersistentHeap.h"
+#include "../include/PageCache.h"
+#include "../include/OffsetPages.h"
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 旧版本头文件中没有该标志；不支持它的内核把地址当作提示，由映射后的地址检查兜底
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+namespace memoryPool
+{
+
+namespace
+{
+
+constexpr uint64_t MAGIC = 0x3150414548504d4dULL; // "MMPHEAP1"
+constexpr uint32_t VERSION = 2; // 2: 页段状态改为 OffsetPages，之后的字段整体后移
+constexpr size_t PAGE_SIZE = PageCache::PAGE_SIZE;
+
+// 小对象每次至少切分的页数，与中心缓存的 span 大小一致
+constexpr size_t SLAB_PAGES = 8;
+
+// 头部的固定前缀（与 Header 的前几个字段一致）：打开已有的堆时只读出它，确定映射的基地址和大小
+struct HeaderPrefix
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t clean;
+    uint64_t base;
+    uint64_t size;
+};
+
+size_t roundUpToPage(size_t bytes)
+{
+    return (bytes + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+}
+
+} // namespace
+
+// 映射开头的头部，全部指针都以偏移保存
+struct PersistentHeap::Header
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t clean;      // 正常关闭时为 1，打开期间为 0
+    uint64_t base;       // 创建时的基地址
+    uint64_t size;       // 映射的总字节数
+    uint64_t root;       // 根对象
+    OffsetPages pages;   // 页段的分配状态
+    uint64_t smallBytes; // 已分配的小对象字节数
+    uint64_t largeBytes; // 已分配的大对象字节数
+    uint64_t freeLists[FREE_LIST_SIZE]; // 各大小类别的自由链表，节点的前 8 字节保存下一个节点的偏移
+};
+
+std::unique_ptr<PersistentHeap> PersistentHeap::open(const char* path, size_t size, uintptr_t base)
+{
+    int fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) return nullptr;
+
+    std::unique_ptr<PersistentHeap> heap = open(fd, size, base);
+    ::close(fd);
+    return heap;
+}
+
+std::unique_ptr<PersistentHeap> PersistentHeap::createMemfd(const char* name, size_t size, uintptr_t base)
+{
+    int fd = memfd_create(name, 0);
+    if (fd < 0) return nullptr;
+
+    std::unique_ptr<PersistentHeap> heap = open(fd, size, base);
+    ::close(fd);
+    return heap;
+}
+
+std::unique_ptr<PersistentHeap> PersistentHeap::open(int sourceFd, size_t size, uintptr_t base)
+{
+    int fd = fcntl(sourceFd, F_DUPFD_CLOEXEC, 0);
+    if (fd < 0) return nullptr;
+
+    auto fail = [fd]
+    {
+        ::close(fd); // 同时释放 flock
+        return nullptr;
+    };
+
+    // 同一个堆只能有一个打开的实例，否则两边的元数据会互相覆盖
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) return fail();
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) return fail();
+
+    const size_t headerBytes = roundUpToPage(sizeof(Header));
+    bool fresh = st.st_size == 0;
+    if (fresh)
+    {
+        size = roundUpToPage(size);
+        if (size < headerBytes + PAGE_SIZE) return fail();
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) return fail();
+    }
+    else
+    {
+        // 已有的堆：先读出头部的固定字段，按创建时的基地址和大小映射
+        static_assert(offsetof(Header, version) == offsetof(HeaderPrefix, version) &&
+                      offsetof(Header, base) == offsetof(HeaderPrefix, base) &&
+                      offsetof(Header, size) == offsetof(HeaderPrefix, size), "header prefix mismatch");
+        HeaderPrefix prefix;
+        if (pread(fd, &prefix, sizeof(prefix), 0) != static_cast<ssize_t>(sizeof(prefix))) return fail();
+        if (prefix.magic != MAGIC || prefix.version != VERSION) return fail();
+        if (prefix.size != static_cast<uint64_t>(st.st_size)) return fail();
+        size = prefix.size;
+        base = prefix.base;
+    }
+
+    void* memory = mmap(reinterpret_cast<void*>(base), size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+    if (memory == MAP_FAILED) return fail();
+    if (reinterpret_cast<uintptr_t>(memory) != base)
+    {
+        munmap(memory, size);
+        return fail();
+    }
+
+    // ftruncate 扩展出的文件内容全为 0，新堆只需写入非零字段
+    Header* header = static_cast<Header*>(memory);
+    if (fresh)
+    {
+        header->magic = MAGIC;
+        header->version = VERSION;
+        header->clean = 1;
+        header->base = base;
+        header->size = size;
+        header->pages.init(headerBytes, size);
+    }
+    bool clean = header->clean != 0;
+    header->clean = 0;
+
+    return std::unique_ptr<PersistentHeap>(
+        new PersistentHeap(fd, static_cast<char*>(memory), size, clean));
+}
+
+PersistentHeap::~PersistentHeap()
+{
+    // 修改已在内核页缓存中，解除映射后仍会写回文件；需要落盘时由调用者先调用 sync()
+    header()->clean = 1;
+    munmap(base_, size_);
+    ::close(fd_);
+}
+
+void* PersistentHeap::allocate(size_t size)
+{
+    size = size ? size : ALIGNMENT;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Header* h = header();
+
+    if (size > MAX_BYTES)
+    {
+        size_t numPages = pagesFor(size);
+        uint64_t offset = h->pages.allocate(base_, numPages);
+        if (!offset) return nullptr;
+        h->largeBytes += numPages * PAGE_SIZE;
+        return at(offset);
+    }
+
+    size_t index = SizeClass::getIndex(size);
+    if (!h->freeLists[index] && !refill(index)) return nullptr;
+
+    uint64_t offset = h->freeLists[index];
+    h->freeLists[index] = *static_cast<uint64_t*>(at(offset));
+    h->smallBytes += (index + 1) * ALIGNMENT;
+    return at(offset);
+}
+
+void PersistentHeap::deallocate(void* ptr, size_t size)
+{
+    if (!ptr) return;
+    size = size ? size : ALIGNMENT;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Header* h = header();
+
+    if (size > MAX_BYTES)
+    {
+        size_t numPages = pagesFor(size);
+        h->largeBytes -= numPages * PAGE_SIZE;
+        h->pages.free(base_, offsetOf(ptr), numPages);
+        return;
+    }
+
+    size_t index = SizeClass::getIndex(size);
+    *static_cast<uint64_t*>(ptr) = h->freeLists[index];
+    h->freeLists[index] = offsetOf(ptr);
+    h->smallBytes -= (index + 1) * ALIGNMENT;
+}
+
+void PersistentHeap::setRoot(void* root)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    header()->root = offsetOf(root);
+}
+
+void* PersistentHeap::root() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return at(header()->root);
+}
+
+bool PersistentHeap::sync()
+{
+    return msync(base_, size_, MS_SYNC) == 0;
+}
+
+size_t PersistentHeap::bytesAllocated() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return header()->smallBytes + header()->largeBytes;
+}
+
+// 为大小类别切分一段页
+bool PersistentHeap::refill(size_t index)
+{
+    size_t blockSize = (index + 1) * ALIGNMENT;
+    size_t numPages = slabPagesFor(blockSize);
+    uint64_t offset = header()->pages.allocate(base_, numPages);
+    if (!offset) return false;
+
+    // 从高地址向低地址串成链表，分配时按地址顺序取出
+    uint64_t head = header()->freeLists[index];
+    size_t count = numPages * PAGE_SIZE / blockSize;
+    for (size_t i = count; i-- > 0;)
+    {
+        uint64_t block = offset + i * blockSize;
+        *static_cast<uint64_t*>(at(block)) = head;
+        head = block;
+    }
+    header()->freeLists[index] = head;
+    return true;
+}
+
+size_t PersistentHeap::pagesFor(size_t size)
+{
+    return (size + PAGE_SIZE - 1) / PAGE_SIZE;
+}
+
+size_t PersistentHeap::slabPagesFor(size_t size)
+{
+    return std::max(SLAB_PAGES, pagesFor(size));
+}
+
+} // namespace memoryPool
@@ -0,0 +1,59 @@
+#include "../include/Prewarm.h"
+#include <algorithm>
+
+namespace memoryPool
+{
+
+// 由统计生成预热配置
+PrewarmProfile PrewarmProfile::fromStats(const PoolStats& stats, size_t maxClasses)
+{
+    std::vector<const ClassStats*> used;
+    for (const ClassStats& cls : stats.classes)
+    {
+        if (cls.allocs) used.push_back(&cls);
+    }
+    std::sort(used.begin(), used.end(), [](const ClassStats* a, const ClassStats* b)
+    {
+        return a->allocs > b->allocs;
+    });
+    if (used.size() > maxClasses) used.resize(maxClasses);
+
+    PrewarmProfile profile;
+    for (const ClassStats* cls : used)
+    {
+        size_t count = cls->allocs * MAX_THREAD_BLOCKS / used.front()->allocs;
+        profile.classes.push_back({cls->size, std::max(count, size_t(1))});
+    }
+    return profile;
+}
+
+// 以文本保存
+bool PrewarmProfile::save(FILE* out) const
+{
+    if (fprintf(out, "# memory pool prewarm profile: <size> <count>\n") < 0) return false;
+    for (const ClassReserve& cls : classes)
+    {
+        if (fprintf(out, "%zu %zu\n", cls.size, cls.count) < 0) return false;
+    }
+    return fflush(out) == 0;
+}
+
+// 读回配置
+PrewarmProfile PrewarmProfile::load(FILE* in)
+{
+    PrewarmProfile profile;
+    char line[128];
+    while (fgets(line, sizeof(line), in))
+    {
+        if (line[0] == '#') continue;
+
+        size_t size = 0, count = 0;
+        if (sscanf(line, "%zu %zu", &size, &count) == 2 && count)
+        {
+            profile.classes.push_back({size, count});
+        }
+    }
+    return profile;
+}
+
+} // namespace memoryPool
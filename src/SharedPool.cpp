@@ -0,0 +1,397 @@
+#include "../include/SharedPool.h"
+#include "../include/OffsetPages.h"
+#include "../include/PageCache.h"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace memoryPool
+{
+
+namespace
+{
+
+constexpr uint64_t MAGIC = 0x314c4f4f50484d53ULL; // "SMHPOOL1"
+constexpr uint32_t VERSION = 1;
+constexpr size_t PAGE_SIZE = PageCache::PAGE_SIZE;
+
+// 中心层栈顶的低 40 位是偏移，高 24 位是每次修改递增的版本号
+constexpr unsigned OFFSET_BITS = 40;
+constexpr uint64_t OFFSET_MASK = (uint64_t(1) << OFFSET_BITS) - 1;
+constexpr size_t MAX_SEGMENT_SIZE = size_t(1) << OFFSET_BITS;
+
+// 线程缓存每个大小类别的容量，超过时归还 3/4
+constexpr uint32_t LOCAL_LIMIT = 64;
+
+// 页层每次为小对象切分的最少页数，与中心缓存的 span 大小一致
+constexpr size_t SLAB_PAGES = 8;
+
+size_t roundUpToPage(size_t bytes)
+{
+    return (bytes + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+}
+
+// 线程缓存未命中时从中心层取的内存块数：每批约 8KB，1 到 32 个
+size_t batchFor(size_t size)
+{
+    return std::max(size_t(1), std::min(size_t(32), 8192 / size));
+}
+
+} // namespace
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the central tier needs address-free atomics");
+
+// 共享内存段开头的头部
+struct SharedPool::Header
+{
+    std::atomic<uint64_t> magic; // 初始化完成后才写入，attach 据此判断段是否可用
+    uint32_t version;
+    uint64_t size;
+
+    // 页层：进程间共享的健壮互斥锁及其保护的页段状态
+    pthread_mutex_t pageLock;
+    OffsetPages pages;
+
+    // 中心层：每个大小类别一个无锁栈，节点的前 8 字节保存下一个节点的偏移
+    std::atomic<uint64_t> central[FREE_LIST_SIZE];
+};
+
+// 进程私有的线程缓存，链接仍使用偏移
+struct SharedPool::LocalCache
+{
+    SharedPool* pool;
+    LocalCache* prev; // 本进程线程缓存链表
+    LocalCache* next;
+    uint64_t heads[FREE_LIST_SIZE];
+    uint32_t counts[FREE_LIST_SIZE];
+};
+
+std::unique_ptr<SharedPool> SharedPool::create(const char* name, size_t size)
+{
+    size = roundUpToPage(size);
+    const size_t headerBytes = roundUpToPage(sizeof(Header));
+    if (size < headerBytes + PAGE_SIZE || size > MAX_SEGMENT_SIZE) return nullptr;
+
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) return nullptr;
+
+    void* memory = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0)
+    {
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (memory == MAP_FAILED)
+    {
+        close(fd);
+        shm_unlink(name);
+        return nullptr;
+    }
+
+    // 新段内容全为 0：中心层的栈都为空，只需初始化锁和页层
+    Header* header = static_cast<Header*>(memory);
+    header->version = VERSION;
+    header->size = size;
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&header->pageLock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    header->pages.init(headerBytes, size);
+    header->magic.store(MAGIC, std::memory_order_release);
+
+    return std::unique_ptr<SharedPool>(new SharedPool(fd, static_cast<char*>(memory), size));
+}
+
+std::unique_ptr<SharedPool> SharedPool::attach(const char* name)
+{
+    int fd = shm_open(name, O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header))
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    size_t size = st.st_size;
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    Header* header = static_cast<Header*>(memory);
+    if (header->magic.load(std::memory_order_acquire) != MAGIC ||
+        header->version != VERSION || header->size != size)
+    {
+        munmap(memory, size);
+        close(fd);
+        return nullptr;
+    }
+
+    return std::unique_ptr<SharedPool>(new SharedPool(fd, static_cast<char*>(memory), size));
+}
+
+bool SharedPool::unlink(const char* name)
+{
+    return shm_unlink(name) == 0;
+}
+
+SharedPool::SharedPool(int fd, char* base, size_t size)
+    : fd_(fd), base_(base), size_(size)
+{
+    if (pthread_key_create(&key_, &SharedPool::destroyLocalCache) != 0)
+    {
+        munmap(base_, size_);
+        close(fd_);
+        throw std::bad_alloc();
+    }
+}
+
+SharedPool::~SharedPool()
+{
+    // 删除 key 之后，仍持有线程缓存的线程退出时不会再调用 destroyLocalCache
+    pthread_key_delete(key_);
+
+    LocalCache* cache = caches_;
+    while (cache)
+    {
+        LocalCache* next = cache->next;
+        flushAll(cache);
+        munmap(cache, sizeof(LocalCache));
+        cache = next;
+    }
+
+    munmap(base_, size_);
+    close(fd_);
+}
+
+void* SharedPool::allocate(size_t size)
+{
+    size = size ? size : ALIGNMENT;
+
+    // 大对象直接按页分配
+    if (__builtin_expect(size > MAX_BYTES, 0))
+    {
+        uint64_t offset = allocatePages(pagesFor(size));
+        return offset ? base_ + offset : nullptr;
+    }
+
+    size_t index = SizeClass::getIndex(size);
+    LocalCache* cache = localCache();
+    uint64_t offset = cache->heads[index];
+    if (__builtin_expect(offset != 0, 1))
+    {
+        cache->heads[index] = link(offset);
+        cache->counts[index]--;
+        return base_ + offset;
+    }
+
+    offset = fetch(cache, index);
+    return offset ? base_ + offset : nullptr;
+}
+
+void SharedPool::deallocate(void* ptr, size_t size)
+{
+    if (!ptr) return;
+    size = size ? size : ALIGNMENT;
+
+    uint64_t offset = toOffset(ptr);
+    if (__builtin_expect(size > MAX_BYTES, 0))
+    {
+        freePages(offset, pagesFor(size));
+        return;
+    }
+
+    size_t index = SizeClass::getIndex(size);
+    LocalCache* cache = localCache();
+    link(offset) = cache->heads[index];
+    cache->heads[index] = offset;
+    if (__builtin_expect(++cache->counts[index] > LOCAL_LIMIT, 0))
+    {
+        flush(cache, index, LOCAL_LIMIT - LOCAL_LIMIT / 4);
+    }
+}
+
+void SharedPool::releaseThreadCache()
+{
+    if (void* cache = pthread_getspecific(key_))
+    {
+        flushAll(static_cast<LocalCache*>(cache));
+    }
+}
+
+size_t SharedPool::bytesCarved() const
+{
+    Header* h = header();
+    pthread_mutex_t* lock = &h->pageLock;
+    if (pthread_mutex_lock(lock) == EOWNERDEAD) pthread_mutex_consistent(lock);
+    size_t carved = h->pages.carvedBytes(roundUpToPage(sizeof(Header)));
+    pthread_mutex_unlock(lock);
+    return carved;
+}
+
+SharedPool::LocalCache* SharedPool::createLocalCache()
+{
+    // 线程缓存较大（每个大小类别一个链表头和计数），直接用 mmap 分配，未使用的大小类别不占用物理页
+    void* memory = mmap(nullptr, sizeof(LocalCache), PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) throw std::bad_alloc();
+
+    LocalCache* cache = static_cast<LocalCache*>(memory);
+    cache->pool = this;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cache->next = caches_;
+        if (caches_) caches_->prev = cache;
+        caches_ = cache;
+    }
+
+    pthread_setspecific(key_, cache);
+    return cache;
+}
+
+void SharedPool::destroyLocalCache(void* instance)
+{
+    LocalCache* cache = static_cast<LocalCache*>(instance);
+    SharedPool* pool = cache->pool;
+
+    pool->flushAll(cache);
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex_);
+        if (cache->prev) cache->prev->next = cache->next;
+        else pool->caches_ = cache->next;
+        if (cache->next) cache->next->prev = cache->prev;
+    }
+    munmap(cache, sizeof(LocalCache));
+}
+
+// 把线程缓存链表的前 count 个内存块作为一条链压入中心层
+void SharedPool::flush(LocalCache* cache, size_t index, size_t count)
+{
+    uint64_t first = cache->heads[index];
+    uint64_t last = first;
+    for (size_t i = 1; i < count; ++i)
+    {
+        last = link(last);
+    }
+
+    cache->heads[index] = link(last);
+    cache->counts[index] -= static_cast<uint32_t>(count);
+    pushCentral(index, first, last);
+}
+
+void SharedPool::flushAll(LocalCache* cache)
+{
+    for (size_t index = 0; index < FREE_LIST_SIZE; ++index)
+    {
+        if (cache->counts[index]) flush(cache, index, cache->counts[index]);
+    }
+}
+
+// 线程缓存未命中
+uint64_t SharedPool::fetch(LocalCache* cache, size_t index)
+{
+    size_t blockSize = (index + 1) * ALIGNMENT;
+    size_t batch = batchFor(blockSize);
+
+    for (size_t i = 0; i < batch; ++i)
+    {
+        uint64_t offset = popCentral(index);
+        if (!offset) break;
+        link(offset) = cache->heads[index];
+        cache->heads[index] = offset;
+        cache->counts[index]++;
+    }
+
+    if (!cache->heads[index])
+    {
+        // 中心层为空：切分新的页段，一批放入线程缓存，其余压入中心层
+        size_t numPages = std::max(SLAB_PAGES, pagesFor(blockSize));
+        uint64_t span = allocatePages(numPages);
+        if (!span) return 0;
+
+        size_t count = numPages * PAGE_SIZE / blockSize;
+        size_t local = std::min(batch, count);
+        for (size_t i = 0; i + 1 < count; ++i)
+        {
+            link(span + i * blockSize) = span + (i + 1) * blockSize;
+        }
+        link(span + (local - 1) * blockSize) = 0;
+        if (count > local)
+        {
+            pushCentral(index, span + local * blockSize, span + (count - 1) * blockSize);
+        }
+        cache->heads[index] = span;
+        cache->counts[index] = static_cast<uint32_t>(local);
+    }
+
+    uint64_t offset = cache->heads[index];
+    cache->heads[index] = link(offset);
+    cache->counts[index]--;
+    return offset;
+}
+
+// 从中心层弹出一个内存块
+uint64_t SharedPool::popCentral(size_t index)
+{
+    std::atomic<uint64_t>& head = header()->central[index];
+    uint64_t old = head.load(std::memory_order_acquire);
+    while (old & OFFSET_MASK)
+    {
+        // 节点可能刚被其他线程弹出并改写，此时读到的值无效，但栈顶的版本号已变化，CAS 一定失败
+        uint64_t next = __atomic_load_n(&link(old & OFFSET_MASK), __ATOMIC_RELAXED);
+        uint64_t desired = (((old >> OFFSET_BITS) + 1) << OFFSET_BITS) | (next & OFFSET_MASK);
+        if (head.compare_exchange_weak(old, desired, std::memory_order_acquire, std::memory_order_acquire))
+        {
+            return old & OFFSET_MASK;
+        }
+    }
+    return 0;
+}
+
+// 把链 [first, last] 压入中心层
+void SharedPool::pushCentral(size_t index, uint64_t first, uint64_t last)
+{
+    std::atomic<uint64_t>& head = header()->central[index];
+    uint64_t old = head.load(std::memory_order_relaxed);
+    uint64_t desired;
+    do
+    {
+        __atomic_store_n(&link(last), old & OFFSET_MASK, __ATOMIC_RELAXED);
+        desired = (((old >> OFFSET_BITS) + 1) << OFFSET_BITS) | first;
+    } while (!head.compare_exchange_weak(old, desired, std::memory_order_release, std::memory_order_relaxed));
+}
+
+// 页层分配，持有锁的进程异常退出时接管锁
+uint64_t SharedPool::allocatePages(size_t numPages)
+{
+    Header* h = header();
+    if (pthread_mutex_lock(&h->pageLock) == EOWNERDEAD) pthread_mutex_consistent(&h->pageLock);
+    uint64_t offset = h->pages.allocate(base_, numPages);
+    pthread_mutex_unlock(&h->pageLock);
+    return offset;
+}
+
+void SharedPool::freePages(uint64_t offset, size_t numPages)
+{
+    Header* h = header();
+    if (pthread_mutex_lock(&h->pageLock) == EOWNERDEAD) pthread_mutex_consistent(&h->pageLock);
+    h->pages.free(base_, offset, numPages);
+    pthread_mutex_unlock(&h->pageLock);
+}
+
+size_t SharedPool::pagesFor(size_t size)
+{
+    return (size + PAGE_SIZE - 1) / PAGE_SIZE;
+}
+
+} // namespace memoryPool
@@ -1,91 +1,586 @@
 #include "../include/ThreadCache.h"
 #include "../include/CentralCache.h"
+#include "../include/PageCache.h"
+#include "../include/MemoryLimit.h"
+#include "../include/Numa.h"
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
+#include <new>
+#include <vector>
+#include <pthread.h>
+#include <sys/mman.h>
+
 namespace memoryPool
 {
 
-void* ThreadCache::allocate(size_t size)
+namespace
+{
+
+// 线程退出时通过 pthread key 的析构函数清理线程缓存
+pthread_key_t createThreadExitKey(void (*destructor)(void*))
+{
+    pthread_key_t key;
+    pthread_key_create(&key, destructor);
+    return key;
+}
+
+// 写入内存块覆盖的每一页（不改变内容），块开头所在的页除外
+void touchBlock(void* block, size_t size)
+{
+    volatile char* bytes = static_cast<volatile char*>(block);
+    size_t offset = PageCache::PAGE_SIZE - reinterpret_cast<uintptr_t>(block) % PageCache::PAGE_SIZE;
+    for (; offset < size; offset += PageCache::PAGE_SIZE)
+    {
+        bytes[offset] = bytes[offset];
+    }
+}
+
+// 单调时钟的纳秒数
+uint64_t monotonicNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+std::mutex ThreadCache::recycleMutex_;
+ThreadCache* ThreadCache::recycled_ = nullptr;
+ThreadCache* ThreadCache::allInstances_ = nullptr;
+
+ThreadCache* ThreadCache::createInstance()
+{
+    static pthread_key_t exitKey = createThreadExitKey(&ThreadCache::destroyInstance);
+
+    // 优先复用已退出线程留下的实例
+    ThreadCache* instance = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(recycleMutex_);
+        if (recycled_)
+        {
+            instance = recycled_;
+            recycled_ = instance->nextRecycled_;
+        }
+    }
+
+    if (!instance)
+    {
+        // 实例较大（每个大小类别一个链表头和计数），直接用 mmap 分配：
+        // 返回的内存已清零，未使用的大小类别不会占用物理页
+        void* memory = mmap(nullptr, sizeof(ThreadCache), PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) abort();
+
+        instance = new (memory) ThreadCache;
+
+        std::lock_guard<std::mutex> lock(recycleMutex_);
+        instance->nextInstance_ = allInstances_;
+        allInstances_ = instance;
+    }
+
+    instance->central_ = Numa::currentCentral();
+    instance->lastScavenge_ = monotonicNanos();
+    instance->flushSeen_ = flushRequests_.load(std::memory_order_relaxed);
+    instance->alive_.store(true, std::memory_order_release);
+    tlsInstance_ = instance;
+    pthread_setspecific(exitKey, instance);
+    return instance;
+}
+
+ThreadCache* ThreadCache::createForHeap(CentralCache& central)
+{
+    void* memory = mmap(nullptr, sizeof(ThreadCache), PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return nullptr;
+
+    ThreadCache* instance = new (memory) ThreadCache;
+    instance->central_ = &central;
+    instance->lastScavenge_ = monotonicNanos();
+    // 堆的对象随 destroy 整体释放，不参与采样（采样对象不在堆的 span 中）
+    instance->bytesUntilSample_ = PTRDIFF_MAX;
+    instance->alive_.store(true, std::memory_order_release);
+    return instance;
+}
+
+void ThreadCache::discardAll()
+{
+    remoteFree_.store(nullptr, std::memory_order_relaxed);
+    remoteCount_.store(0, std::memory_order_relaxed);
+    for (size_t word = 0; word < activeClasses_.size(); ++word)
+    {
+        uint64_t bits = activeClasses_[word];
+        while (bits)
+        {
+            size_t index = word * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+
+            freeList_[index] = nullptr;
+            freeListSize_[index] = 0;
+            lowWater_[index] = 0;
+        }
+        activeClasses_[word] = 0;
+    }
+}
+
+void ThreadCache::destroyInstance(void* instance)
+{
+    ThreadCache* cache = static_cast<ThreadCache*>(instance);
+
+    // 析构期间如果再有分配，会重新创建实例并再次触发析构
+    tlsInstance_ = nullptr;
+    cache->disableAsyncRefill();
+
+    // 先停止接收远程释放，再把已收到的内存块一并归还
+    // 停止前已读到存活标记的线程仍可能压入少量内存块，它们由复用该实例的新线程取出
+    cache->alive_.store(false, std::memory_order_release);
+    cache->drainRemoteFrees();
+
+    for (size_t index = 0; index < FREE_LIST_SIZE; ++index)
+    {
+        if (cache->freeList_[index])
+        {
+            cache->returnToCentral(cache->freeList_[index], cache->freeListSize_[index], index);
+            cache->freeList_[index] = nullptr;
+        }
+        cache->freeListSize_[index] = 0;
+        cache->lowWater_[index] = 0;
+    }
+    cache->activeClasses_.fill(0);
+
+    std::lock_guard<std::mutex> lock(recycleMutex_);
+    cache->nextRecycled_ = recycled_;
+    recycled_ = cache;
+}
+
+void* ThreadCache::sampleAllocation(size_t size)
+{
+    // 未开启时按默认间隔重置，开启后各线程最迟在一个间隔之后开始采样
+    if (!HeapProfiler::isActive())
+    {
+        bytesUntilSample_ = static_cast<ptrdiff_t>(HeapProfiler::DEFAULT_SAMPLE_RATE);
+        return nullptr;
+    }
+
+    bytesUntilSample_ = static_cast<ptrdiff_t>(HeapProfiler::nextSampleInterval(sampleRng_));
+    return HeapProfiler::allocateSampled(size);
+}
+
+void ThreadCache::pushRemoteFrees(void* head, void* tail, size_t count)
+{
+    void* old = remoteFree_.load(std::memory_order_relaxed);
+    do
+    {
+        *reinterpret_cast<void**>(tail) = old;
+    } while (!remoteFree_.compare_exchange_weak(old, head, std::memory_order_release,
+                                                std::memory_order_relaxed));
+    remoteCount_.fetch_add(count, std::memory_order_relaxed);
+}
+
+void ThreadCache::drainRemoteFrees()
+{
+    remoteCount_.store(0, std::memory_order_relaxed);
+    void* current = remoteFree_.exchange(nullptr, std::memory_order_acquire);
+    while (current)
+    {
+        void* next = *reinterpret_cast<void**>(current);
+
+        // 远程释放链表中混有不同大小类别的内存块，通过页表查询各自的大小
+        size_t index = SizeClass::getIndex(PageCache::getObjectSize(current));
+        if (!freeList_[index]) markActive(index);
+        *reinterpret_cast<void**>(current) = freeList_[index];
+        freeList_[index] = current;
+        freeListSize_[index]++;
+
+        current = next;
+    }
+}
+
+void ThreadCache::reclaimRemoteFrees(ThreadCache* owner)
+{
+    owner->remoteCount_.store(0, std::memory_order_relaxed);
+    void* current = owner->remoteFree_.exchange(nullptr, std::memory_order_acquire);
+
+    // 链表中混有不同大小类别的内存块，连续属于同一中心缓存、同一大小类别的攒成一组归还
+    CentralCache* groupCentral = nullptr;
+    size_t groupIndex = 0;
+    void* groupHead = nullptr;
+    size_t groupCount = 0;
+
+    while (current)
+    {
+        void* next = *reinterpret_cast<void**>(current);
+        Span* span = PageCache::mapObjectToSpan(current);
+        size_t index = SizeClass::getIndex(span->objSize);
+
+        if (span->central != groupCentral || index != groupIndex)
+        {
+            if (groupHead) groupCentral->returnRange(groupHead, groupCount * (groupIndex + 1) * ALIGNMENT, groupIndex);
+            groupCentral = span->central;
+            groupIndex = index;
+            groupHead = nullptr;
+            groupCount = 0;
+        }
+        *reinterpret_cast<void**>(current) = groupHead;
+        groupHead = current;
+        groupCount++;
+
+        current = next;
+    }
+
+    if (groupHead) groupCentral->returnRange(groupHead, groupCount * (groupIndex + 1) * ALIGNMENT, groupIndex);
+}
+
+void ThreadCache::returnToOwners(void* start, size_t index)
+{
+    // 归还给中心缓存的部分
+    void* centralHead = nullptr;
+    size_t centralCount = 0;
+
+    // 连续属于同一所属者的内存块攒成一组，一次压入
+    ThreadCache* groupOwner = nullptr;
+    void* groupHead = nullptr;
+    void* groupTail = nullptr;
+    size_t groupCount = 0;
+
+    // 所属线程空闲、远程释放链表积压过多时不再压入：取回积压的内存块交给中心缓存，本组随本线程的其余部分一起归还
+    auto flushGroup = [&]()
+    {
+        if (groupOwner->remoteCount_.load(std::memory_order_relaxed) < REMOTE_FREE_LIMIT)
+        {
+            groupOwner->pushRemoteFrees(groupHead, groupTail, groupCount);
+            return;
+        }
+
+        reclaimRemoteFrees(groupOwner);
+        *reinterpret_cast<void**>(groupTail) = centralHead;
+        centralHead = groupHead;
+        centralCount += groupCount;
+    };
+
+    void* current = start;
+    while (current)
+    {
+        void* next = *reinterpret_cast<void**>(current);
+        ThreadCache* owner = static_cast<ThreadCache*>(PageCache::getSpanOwner(current));
+
+        if (!owner || owner == this || !owner->alive_.load(std::memory_order_acquire))
+        {
+            *reinterpret_cast<void**>(current) = centralHead;
+            centralHead = current;
+            centralCount++;
+        }
+        else
+        {
+            if (owner != groupOwner)
+            {
+                if (groupOwner) flushGroup();
+                groupOwner = owner;
+                groupTail = current;
+                groupCount = 0;
+                *reinterpret_cast<void**>(current) = nullptr;
+            }
+            else
+            {
+                *reinterpret_cast<void**>(current) = groupHead;
+            }
+            groupHead = current;
+            groupCount++;
+        }
+
+        current = next;
+    }
+
+    if (groupOwner) flushGroup();
+
+    if (centralHead)
+    {
+        returnToCentral(centralHead, centralCount, index);
+    }
+}
+
+void ThreadCache::returnToCentral(void* start, size_t count, size_t index)
+{
+    size_t size = (index + 1) * ALIGNMENT;
+
+    // 没有创建过 NUMA 分片时，全局实例的内存块都属于全局中心缓存；独立堆的内存块都属于堆的中心缓存
+    if (heap_ || Numa::shardCount() == 1)
+    {
+        central_->returnRange(start, count * size, index);
+        return;
+    }
+
+    // 连续属于同一中心缓存的内存块攒成一组，一次归还
+    CentralCache* groupCentral = nullptr;
+    void* groupHead = nullptr;
+    size_t groupCount = 0;
+
+    void* current = start;
+    while (current)
+    {
+        void* next = *reinterpret_cast<void**>(current);
+        CentralCache* central = PageCache::mapObjectToSpan(current)->central;
+
+        if (central != groupCentral)
+        {
+            if (groupCentral) groupCentral->returnRange(groupHead, groupCount * size, index);
+            groupCentral = central;
+            groupHead = nullptr;
+            groupCount = 0;
+        }
+        *reinterpret_cast<void**>(current) = groupHead;
+        groupHead = current;
+        groupCount++;
+
+        current = next;
+    }
+
+    if (groupCentral) groupCentral->returnRange(groupHead, groupCount * size, index);
+}
+
+// 预先填充本地链表
+bool ThreadCache::prefill(size_t size, size_t count)
+{
+    // 大对象不经过线程缓存
+    if (size > MAX_BYTES) return true;
+
+    size_t index = SizeClass::getIndex(size);
+    size_t blockSize = (index + 1) * ALIGNMENT;
+    size_t target = std::min(count, RETURN_THRESHOLD);
+    selectCentral();
+    while (freeListSize_[index] < target)
+    {
+        void* start = central_->fetchRange(index, target - freeListSize_[index]);
+        if (!start) return false;
+        PageCache::claimSpanOwners(start, this);
+
+        // 中心缓存链接内存块时已写过每个块的开头，这里再写入块覆盖的其余页，之后首次使用不会缺页
+        void* tail = start;
+        size_t fetched = 1;
+        touchBlock(start, blockSize);
+        while (*reinterpret_cast<void**>(tail))
+        {
+            tail = *reinterpret_cast<void**>(tail);
+            touchBlock(tail, blockSize);
+            ++fetched;
+        }
+
+        *reinterpret_cast<void**>(tail) = freeList_[index];
+        freeList_[index] = start;
+        freeListSize_[index] += fetched;
+        markActive(index);
+    }
+
+    // 该类别的计数与链表头分布在实例的不同页上，也预先写入一次
+    for (size_t* counter : {&allocCount_[index], &freeCount_[index], &wastedBytes_[index], &lowWater_[index]})
+    {
+        *static_cast<volatile size_t*>(counter) = *counter;
+    }
+    return true;
+}
+
+// 为本实例预先建立页表项
+bool ThreadCache::prefault(bool lockMemory)
+{
+    return PageCache::prefault(this, sizeof(ThreadCache), lockMemory);
+}
+
+// 从页缓存按页分配大对象
+void* ThreadCache::allocateLarge(size_t size)
+{
+    size_t numPages = (size + PageCache::PAGE_SIZE - 1) / PageCache::PAGE_SIZE;
+    return PageCache::getInstance().allocateSpan(numPages, numPages * PageCache::PAGE_SIZE);
+}
+
+// 释放大对象
+void ThreadCache::freeLarge(void* ptr)
+{
+    Span* span = PageCache::mapObjectToSpan(ptr);
+    if (span && span->pageAddr == ptr && span->objSize > MAX_BYTES)
+    {
+        PageCache::getInstance().deallocateSpan(ptr, span->numPages);
+        return;
+    }
+    free(ptr);
+}
+
+size_t ThreadCache::allocateBatch(size_t size, size_t count, void** out)
 {
-    // 处理0大小的分配请求
     if (size == 0)
     {
-        size = ALIGNMENT; // 至少分配一个对齐大小
+        size = ALIGNMENT;
     }
-    
+
     if (size > MAX_BYTES)
     {
-        // 大对象直接从系统分配
-        return malloc(size);
+        // 大对象逐个从系统分配（实时模式下从页缓存）
+        bool fixedHeap = fixedHeap_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = fixedHeap ? allocateLarge(size) : malloc(size);
+            if (!out[i]) return i;
+            largeAllocCount_++;
+        }
+        return count;
     }
 
     size_t index = SizeClass::getIndex(size);
+    size_t filled = 0;
 
-    // 更新自由链表大小
-    freeListSize_[index]--;
+    // 先取空本地自由链表
+    while (filled < count && freeList_[index])
+    {
+        void* ptr = freeList_[index];
+        freeList_[index] = *reinterpret_cast<void**>(ptr);
+        freeListSize_[index]--;
+        allocCount_[index]++;
+        out[filled++] = ptr;
+    }
+    lowWater_[index] = std::min(lowWater_[index], freeListSize_[index]);
 
-    // 检查线程本地自由链表
-    // 如果 freeList_[index] 不为空，表示该链表中有可用内存块
-    if (void* ptr = freeList_[index])
+    // 剩余数量较大时直接向中心缓存按需批量获取整条链表，不经过本地自由链表（NUMA 分片下为当前所在节点的分片）
+    selectCentral();
+    while (count - filled >= getBatchNum(size))
     {
-        freeList_[index] = *reinterpret_cast<void**>(ptr); // 将freeList_[index]指向的内存块的下一个内存块地址（取决于内存块的实现）
-        return ptr;
+        void* start = central_->fetchRange(index, count - filled);
+        // 因硬限制失败时先归还缓存的内存再重试一次
+        if (!start && !heap_ && MemoryLimit::relieveAfterFailure())
+        {
+            start = central_->fetchRange(index, count - filled);
+        }
+        if (!start) break;
+        PageCache::claimSpanOwners(start, this);
+
+        for (void* current = start; current; current = *reinterpret_cast<void**>(current))
+        {
+            out[filled++] = current;
+            allocCount_[index]++;
+        }
     }
 
-    // 如果线程本地自由链表为空，则从中心缓存获取一批内存
-    return fetchFromCentralCache(index);
+    // 剩余数量较少时走普通路径，顺便补充本地自由链表
+    while (filled < count)
+    {
+        void* ptr = allocateByIndex(index);
+        if (!ptr) break;
+        out[filled++] = ptr;
+    }
+
+    wastedBytes_[index] += ((index + 1) * ALIGNMENT - size) * filled;
+    return filled;
 }
 
-void ThreadCache::deallocate(void* ptr, size_t size)
+void ThreadCache::deallocateBatch(size_t size, size_t count, void** ptrs)
 {
+    if (count == 0) return;
+
     if (size > MAX_BYTES)
     {
-        free(ptr);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (HeapProfiler::isSampled(ptrs[i])) HeapProfiler::deallocateSampled(ptrs[i]);
+            else freeLarge(ptrs[i]);
+        }
+        largeFreeCount_ += count;
         return;
     }
 
     size_t index = SizeClass::getIndex(size);
+    freeCount_[index] += count;
 
-    // 插入到线程本地自由链表
-    *reinterpret_cast<void**>(ptr) = freeList_[index];
-    freeList_[index] = ptr;
+    // 把所有内存块串成一条链表，采样对象单独交还给采样分析器
+    void* head = nullptr;
+    void* tail = nullptr;
+    size_t linked = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (__builtin_expect(HeapProfiler::isSampled(ptrs[i]), 0))
+        {
+            HeapProfiler::deallocateSampled(ptrs[i]);
+            continue;
+        }
 
-     // 更新自由链表大小
-    freeListSize_[index]++; // 增加对应大小类的自由链表大小
+        if (tail) *reinterpret_cast<void**>(tail) = ptrs[i];
+        else head = ptrs[i];
+        tail = ptrs[i];
+        linked++;
+    }
+    if (!head) return;
 
-    // 判断是否需要将部分内存回收给中心缓存
-    if (shouldReturnToCentralCache(index))
+    if (linked > RETURN_THRESHOLD)
     {
-        returnToCentralCache(freeList_[index], size);
+        // 数量超过本地容量，整条链表直接归还（按所属者分流）
+        *reinterpret_cast<void**>(tail) = nullptr;
+        returnToOwners(head, index);
+        return;
     }
-}
 
-// 判断是否需要将内存回收给中心缓存
-bool ThreadCache::shouldReturnToCentralCache(size_t index)
-{
-    // 设定阈值，例如：当自由链表的大小超过一定数量时
-    size_t threshold = 64; // 例如，64个内存块
-    return (freeListSize_[index] > threshold);
+    // 整条链表接到本地自由链表头部
+    if (!freeList_[index]) markActive(index);
+    *reinterpret_cast<void**>(tail) = freeList_[index];
+    freeList_[index] = head;
+    freeListSize_[index] += linked;
+
+    if (shouldReturnToCentralCache(index))
+    {
+        returnToCentralCache(freeList_[index], (index + 1) * ALIGNMENT);
+    }
 }
 
 void* ThreadCache::fetchFromCentralCache(size_t index)
 {
+    MEMORY_POOL_PROBE_START(probeStart);
+    checkPressure();
+    maybeScavenge();
+
+    // 先取回其他线程释放的、属于本线程 span 的内存块，以及后台线程已送达的补充
+    if (remoteFree_.load(std::memory_order_relaxed) || refill_)
+    {
+        if (remoteFree_.load(std::memory_order_relaxed)) drainRemoteFrees();
+        if (refill_) collectRefills();
+        if (void* ptr = freeList_[index])
+        {
+            freeList_[index] = *reinterpret_cast<void**>(ptr);
+            freeListSize_[index]--;
+            lowWater_[index] = std::min(lowWater_[index], freeListSize_[index]);
+            allocCount_[index]++;
+            if (refill_) requestRefill(index);
+            MEMORY_POOL_PROBE_END(FETCH_FROM_CENTRAL, probeStart);
+            return ptr;
+        }
+    }
+
     size_t size = (index + 1) * ALIGNMENT;
     // 根据对象内存大小计算批量获取的数量
     size_t batchNum = getBatchNum(size);
-    // 从中心缓存批量获取内存
-    void* start = CentralCache::getInstance().fetchRange(index, batchNum);
+    // 从中心缓存批量获取内存（NUMA 分片下为当前所在节点的分片）
+    selectCentral();
+    void* start = central_->fetchRange(index, batchNum);
+    // 因硬限制失败时先归还缓存的内存再重试一次
+    if (!start && !heap_ && MemoryLimit::relieveAfterFailure())
+    {
+        start = central_->fetchRange(index, batchNum);
+    }
     if (!start) return nullptr;
 
-    // 更新自由链表大小
-    freeListSize_[index] += batchNum; // 增加对应大小类的自由链表大小
+    // 从新 span 切出的内存块由本线程拥有，之后其他线程释放时会送回本线程
+    PageCache::claimSpanOwners(start, this);
 
-    // 取一个返回，其余放入线程本地自由链表
-    void* result = start;
-    if (batchNum > 1)
+    // 中心缓存可能返回少于 batchNum 个内存块，按实际链表长度计数
+    size_t count = 0;
+    for (void* current = start; current; current = *reinterpret_cast<void**>(current))
     {
-        freeList_[index] = *reinterpret_cast<void**>(start);
+        ++count;
     }
-    
+
+    // 取一个返回，其余放入线程本地自由链表
+    void* result = start;
+    if (count > 1) markActive(index);
+    freeList_[index] = *reinterpret_cast<void**>(start);
+    freeListSize_[index] += count - 1; // 增加对应大小类的自由链表大小
+    allocCount_[index]++;
+
+    MEMORY_POOL_PROBE_END(FETCH_FROM_CENTRAL, probeStart);
     return result;
 }
 
@@ -94,9 +589,6 @@ void ThreadCache::returnToCentralCache(void* start, size_t size)
     // 根据大小计算对应的索引
     size_t index = SizeClass::getIndex(size);
 
-    // 获取对齐后的实际块大小
-    size_t alignedSize = SizeClass::roundUp(size);
-
     // 计算要归还内存块数量
     size_t batchNum = freeListSize_[index];
     if (batchNum <= 1) return; // 如果只有一个块，则不归还
@@ -132,14 +624,179 @@ void ThreadCache::returnToCentralCache(void* start, size_t size)
         // 更新自由链表大小
         freeListSize_[index] = keepNum;
 
-        // 将剩余部分返回给CentralCache
+        // 将剩余部分归还：属于其他线程的送回所属线程，其余返回给CentralCache
         if (returnNum > 0 && nextNode != nullptr)
         {
-            CentralCache::getInstance().returnRange(nextNode, returnNum * alignedSize, index);
+            returnToOwners(nextNode, index);
+        }
+    }
+
+    checkPressure();
+    maybeScavenge();
+}
+
+void ThreadCache::maybeScavenge()
+{
+    uint64_t interval = decayIntervalNs_.load(std::memory_order_relaxed);
+    if (interval == 0) return;
+
+    uint64_t now = monotonicNanos();
+    if (now - lastScavenge_ < interval) return;
+
+    lastScavenge_ = now;
+    scavenge();
+}
+
+void ThreadCache::checkPressure()
+{
+    if (heap_) return;
+
+    uint64_t requested = flushRequests_.load(std::memory_order_relaxed);
+    if (__builtin_expect(requested != flushSeen_, 0))
+    {
+        flushSeen_ = requested;
+        releaseAll();
+    }
+
+    if (__builtin_expect(PageCache::getInstance().pressurePending(), 0))
+    {
+        MemoryLimit::relievePending();
+    }
+}
+
+void ThreadCache::flushAllThreads()
+{
+    uint64_t requested = flushRequests_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (ThreadCache* self = tlsInstance_)
+    {
+        self->flushSeen_ = requested;
+        self->releaseAll();
+    }
+}
+
+void ThreadCache::scavenge()
+{
+    for (size_t word = 0; word < activeClasses_.size(); ++word)
+    {
+        uint64_t bits = activeClasses_[word];
+        while (bits)
+        {
+            size_t index = word * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+
+            // 低水位部分在整个间隔内一直留在链表里，归还它们不会让本线程多一次未命中
+            size_t cold = std::min(lowWater_[index], freeListSize_[index]);
+            if (cold > 0) releaseColdBlocks(index, cold);
+
+            lowWater_[index] = freeListSize_[index];
+            if (!freeList_[index])
+            {
+                activeClasses_[word] &= ~(uint64_t(1) << (index % 64));
+            }
         }
     }
 }
 
+void ThreadCache::releaseColdBlocks(size_t index, size_t count)
+{
+    size_t keepNum = freeListSize_[index] - count;
+    void* release;
+    if (keepNum == 0)
+    {
+        release = freeList_[index];
+        freeList_[index] = nullptr;
+    }
+    else
+    {
+        // 链表按后进先出使用，尾部是最久未被用到的内存块
+        void* splitNode = freeList_[index];
+        for (size_t i = 0; i < keepNum - 1; ++i)
+        {
+            splitNode = *reinterpret_cast<void**>(splitNode);
+        }
+        release = *reinterpret_cast<void**>(splitNode);
+        *reinterpret_cast<void**>(splitNode) = nullptr;
+    }
+
+    freeListSize_[index] = keepNum;
+    if (release) returnToOwners(release, index);
+}
+
+void ThreadCache::releaseAll()
+{
+    drainRemoteFrees();
+    if (refill_) collectRefills();
+
+    for (size_t word = 0; word < activeClasses_.size(); ++word)
+    {
+        uint64_t bits = activeClasses_[word];
+        while (bits)
+        {
+            size_t index = word * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+
+            if (freeListSize_[index] > 0) releaseColdBlocks(index, freeListSize_[index]);
+            lowWater_[index] = 0;
+        }
+        activeClasses_[word] = 0;
+    }
+}
+
+void ThreadCache::enableAsyncRefill()
+{
+    if (refill_) return;
+    refillMailbox_ = AsyncRefill::attach(refillMailbox_, this);
+    refill_ = refillMailbox_;
+}
+
+void ThreadCache::disableAsyncRefill()
+{
+    if (!refill_) return;
+
+    // 关闭后后台线程不再送达新的批量，已送达的取回本地链表，在途请求作废
+    AsyncRefill::detach(refill_);
+    collectRefills();
+    std::fill(std::begin(refill_->pending), std::end(refill_->pending), 0);
+    refill_ = nullptr;
+}
+
+void ThreadCache::requestRefill(size_t index)
+{
+    collectRefills();
+
+    uint64_t bit = uint64_t(1) << (index % 64);
+    uint64_t& pending = refill_->pending[index / 64];
+    size_t batchNum = getBatchNum((index + 1) * ALIGNMENT);
+    if (freeListSize_[index] >= (batchNum + 1) / 2 || (pending & bit)) return;
+
+    // 送达后本地链表不超过容量阈值，避免刚补充就触发归还
+    size_t count = std::min(batchNum, RETURN_THRESHOLD - freeListSize_[index]);
+
+    // 与同步补充一样按线程当前所在的节点选择中心缓存，由后台线程从中取
+    selectCentral();
+    if (refill_->requests.push({static_cast<uint32_t>(index), static_cast<uint32_t>(count), central_}))
+    {
+        pending |= bit;
+        AsyncRefill::wake();
+    }
+}
+
+void ThreadCache::collectRefills()
+{
+    RefillMailbox::Batch batch;
+    while (refill_->batches.pop(batch))
+    {
+        size_t index = batch.index;
+        refill_->pending[index / 64] &= ~(uint64_t(1) << (index % 64));
+        if (!batch.head) continue;
+
+        if (!freeList_[index]) markActive(index);
+        *reinterpret_cast<void**>(batch.tail) = freeList_[index];
+        freeList_[index] = batch.head;
+        freeListSize_[index] += batch.count;
+    }
+}
+
 // 计算批量获取内存块的数量
 size_t ThreadCache::getBatchNum(size_t size)
 {
@@ -163,4 +820,43 @@ size_t ThreadCache::getBatchNum(size_t size)
     return std::max(sizeof(1), std::min(maxNum, baseNum));
 }
 
+void ThreadCache::collectStats(PoolStats& stats)
+{
+    std::lock_guard<std::mutex> lock(recycleMutex_);
+    collectStats(stats, allInstances_);
+}
+
+void ThreadCache::collectStats(PoolStats& stats, ThreadCache* first)
+{
+    // 分配时浪费的累计字节数，最后按存活比例折算成内部碎片
+    std::vector<size_t, SystemAllocator<size_t>> wasted(FREE_LIST_SIZE, 0);
+
+    for (ThreadCache* cache = first; cache; cache = cache->nextInstance_)
+    {
+        stats.threadCaches++;
+        stats.largeAllocs += cache->largeAllocCount_;
+        stats.largeFrees += cache->largeFreeCount_;
+
+        for (size_t index = 0; index < FREE_LIST_SIZE; ++index)
+        {
+            ClassStats& cls = stats.classes[index];
+            cls.allocs += cache->allocCount_[index];
+            cls.frees += cache->freeCount_[index];
+            cls.threadCacheBytes += cache->freeListSize_[index] * cls.size;
+            wasted[index] += cache->wastedBytes_[index];
+        }
+    }
+
+    for (size_t index = 0; index < FREE_LIST_SIZE; ++index)
+    {
+        ClassStats& cls = stats.classes[index];
+        // 跨线程释放时单个实例的释放次数可能多于分配次数，只有总和才有意义
+        if (cls.allocs > cls.frees)
+        {
+            cls.internalFragmentation = static_cast<size_t>(
+                static_cast<double>(wasted[index]) * (cls.allocs - cls.frees) / cls.allocs);
+        }
+    }
+}
+
 } // namespace memoryPool
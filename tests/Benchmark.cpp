@@ -0,0 +1,682 @@
+#include "../include/MemoryPool.h" // 被测试的内存池
+#include "../include/Instrument.h" // 分层计时直方图
+#include <iostream> // 控制台输出
+#include <fstream> // 写出 JSON 结果
+#include <sstream> // 拼接 JSON
+#include <vector> // 保存内存块指针
+#include <string> // 参数解析
+#include <thread> // 多线程负载
+#include <mutex> // 生产者/消费者队列
+#include <condition_variable> // 生产者/消费者队列
+#include <deque> // 生产者/消费者队列
+#include <random> // 随机大小
+#include <algorithm> // 打乱释放顺序
+#include <chrono> // 计时
+#include <cstring> // strcmp、memset
+#include <cstdio> // 读取 /proc/self/statm、写出 CSV
+#include <atomic> // 碎片测试的阶段标记
+#include <sys/resource.h> // 峰值 RSS、缺页次数
+#include <sys/wait.h> // 等待子进程
+#include <unistd.h> // fork、pipe
+
+using namespace memoryPool;
+using namespace std::chrono;
+
+// 分配器基准测试套件
+// 运行经典的分配器负载（larson、threadtest、xmalloc 生产者/消费者、cache-scratch、cache-thrash、混合大小），
+// 线程数从 1 扫描到核数，报告吞吐量、单次操作延迟的 p50/p99/p99.9、峰值/最终 RSS 和缺页次数，以 JSON 输出。
+// 每个（负载, 分配器, 线程数）组合在独立的子进程中运行，RSS 和缺页统计互不影响。
+//
+// 用法: benchmark [--output 文件] [--workload 名称] [--allocator pool|system] [--max-threads N] [--scale X]
+// 两次运行的结果可用 scripts/compare_bench.py 对比。
+//
+// 长时间碎片测试: benchmark --mode fragmentation [--duration 秒] [--interval 毫秒] [--csv 文件]
+//                 [--allocator pool|system] [--scale X]
+// 交替运行小对象/大对象阶段，按固定间隔把 RSS 和内存池各层的字节数写成 CSV 时间序列。
+
+// 被测分配器
+struct Allocator
+{
+    const char* name;
+    void* (*allocate)(size_t);
+    void (*deallocate)(void*, size_t);
+};
+
+static const Allocator ALLOCATORS[] = {
+    {"pool", [](size_t size) { return MemoryPool::allocate(size); },
+             [](void* ptr, size_t size) { MemoryPool::deallocate(ptr, size); }},
+    {"system", [](size_t size) { return malloc(size); },
+               [](void* ptr, size_t) { free(ptr); }},
+};
+
+// 对数-线性延迟直方图：每个 2 的幂区间再分 16 档，相对误差约 6%，不随样本数增长占用内存
+class LatencyHistogram
+{
+public:
+    void add(uint64_t ns)
+    {
+        buckets_[bucketOf(ns)]++;
+        count_++;
+    }
+
+    void merge(const LatencyHistogram& other)
+    {
+        for (size_t i = 0; i < NUM_BUCKETS; ++i) buckets_[i] += other.buckets_[i];
+        count_ += other.count_;
+    }
+
+    uint64_t count() const { return count_; }
+
+    // 返回第 p 分位数所在档的上界（纳秒）
+    uint64_t percentile(double p) const
+    {
+        if (count_ == 0) return 0;
+        uint64_t target = static_cast<uint64_t>(p * count_);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < NUM_BUCKETS; ++i)
+        {
+            seen += buckets_[i];
+            if (seen > target) return upperBound(i);
+        }
+        return upperBound(NUM_BUCKETS - 1);
+    }
+
+private:
+    static constexpr size_t SUB_BITS = 4;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BITS;
+    static constexpr size_t NUM_BUCKETS = 64 * SUB_BUCKETS;
+
+    static size_t bucketOf(uint64_t ns)
+    {
+        if (ns < SUB_BUCKETS) return ns;
+        size_t exponent = 63 - __builtin_clzll(ns); // ns 落在 [2^exponent, 2^(exponent+1))
+        size_t sub = (ns >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1);
+        return (exponent - SUB_BITS + 1) * SUB_BUCKETS + sub;
+    }
+
+    static uint64_t upperBound(size_t bucket)
+    {
+        if (bucket < SUB_BUCKETS) return bucket;
+        size_t exponent = bucket / SUB_BUCKETS + SUB_BITS - 1;
+        size_t sub = bucket % SUB_BUCKETS;
+        return ((SUB_BUCKETS + sub + 1) << (exponent - SUB_BITS)) - 1;
+    }
+
+    uint64_t buckets_[NUM_BUCKETS] = {};
+    uint64_t count_ = 0;
+};
+
+// 每个线程的计时包装：逐次记录分配和释放的耗时
+class TimedAllocator
+{
+public:
+    explicit TimedAllocator(const Allocator& allocator) : allocator_(allocator) {}
+
+    void* allocate(size_t size)
+    {
+        auto start = steady_clock::now();
+        void* ptr = allocator_.allocate(size);
+        histogram_.add(duration_cast<nanoseconds>(steady_clock::now() - start).count());
+        *static_cast<char*>(ptr) = 1; // 触及首字节，使缺页计入负载
+        return ptr;
+    }
+
+    void deallocate(void* ptr, size_t size)
+    {
+        auto start = steady_clock::now();
+        allocator_.deallocate(ptr, size);
+        histogram_.add(duration_cast<nanoseconds>(steady_clock::now() - start).count());
+    }
+
+    const LatencyHistogram& histogram() const { return histogram_; }
+
+private:
+    const Allocator& allocator_;
+    LatencyHistogram histogram_;
+};
+
+// 一次负载运行的参数与汇总
+struct RunContext
+{
+    const Allocator& allocator;
+    size_t threads;
+    double scale;
+
+    std::mutex mutex;
+    LatencyHistogram histogram;
+
+    size_t iterations(size_t base) const
+    {
+        return std::max<size_t>(1, static_cast<size_t>(base * scale));
+    }
+
+    void merge(const TimedAllocator& timed)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        histogram.merge(timed.histogram());
+    }
+};
+
+// 启动 n 个线程运行 body(线程编号) 并等待结束
+template <typename Body>
+static void runThreads(size_t n, Body body)
+{
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < n; ++i)
+    {
+        threads.emplace_back(body, i);
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+// larson：模拟服务器，每个线程随机替换自己持有的对象；每一代结束后由新线程接手上一代的对象，
+// 因此大量对象由非分配线程释放
+static void larson(RunContext& ctx)
+{
+    constexpr size_t SLOTS = 1000;
+    constexpr size_t GENERATIONS = 4;
+    const size_t rounds = ctx.iterations(50000);
+
+    std::vector<std::vector<std::pair<void*, size_t>>> slots(ctx.threads);
+    for (auto& own : slots)
+    {
+        own.assign(SLOTS, {nullptr, 0});
+    }
+
+    for (size_t generation = 0; generation < GENERATIONS; ++generation)
+    {
+        runThreads(ctx.threads, [&](size_t id)
+        {
+            TimedAllocator timed(ctx.allocator);
+            std::mt19937 rng(static_cast<unsigned>(id * 7919 + generation));
+            auto& own = slots[id];
+            for (size_t i = 0; i < rounds; ++i)
+            {
+                auto& slot = own[rng() % SLOTS];
+                if (slot.first) timed.deallocate(slot.first, slot.second);
+                slot.second = 8 + rng() % 1017;
+                slot.first = timed.allocate(slot.second);
+            }
+            ctx.merge(timed);
+        });
+    }
+
+    runThreads(ctx.threads, [&](size_t id)
+    {
+        TimedAllocator timed(ctx.allocator);
+        for (auto& slot : slots[id])
+        {
+            if (slot.first) timed.deallocate(slot.first, slot.second);
+        }
+        ctx.merge(timed);
+    });
+}
+
+// threadtest：每个线程反复分配一批同大小对象后全部释放
+static void threadtest(RunContext& ctx)
+{
+    constexpr size_t BATCH = 10000;
+    constexpr size_t SIZE = 64;
+    const size_t rounds = ctx.iterations(20);
+
+    runThreads(ctx.threads, [&](size_t)
+    {
+        TimedAllocator timed(ctx.allocator);
+        std::vector<void*> ptrs(BATCH);
+        for (size_t round = 0; round < rounds; ++round)
+        {
+            for (auto& ptr : ptrs) ptr = timed.allocate(SIZE);
+            for (auto& ptr : ptrs) timed.deallocate(ptr, SIZE);
+        }
+        ctx.merge(timed);
+    });
+}
+
+// xmalloc：生产者分配一批对象交给消费者释放，每对生产者/消费者共享一个有界队列
+static void xmalloc(RunContext& ctx)
+{
+    constexpr size_t BATCH = 100;
+    constexpr size_t QUEUE_LIMIT = 64;
+    const size_t batches = ctx.iterations(2000);
+    const size_t pairs = std::max<size_t>(1, ctx.threads / 2);
+
+    struct Channel
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::vector<std::pair<void*, size_t>>> queue;
+        bool done = false;
+    };
+    std::vector<Channel> channels(pairs);
+
+    runThreads(pairs * 2, [&](size_t id)
+    {
+        TimedAllocator timed(ctx.allocator);
+        Channel& channel = channels[id / 2];
+
+        if (id % 2 == 0)
+        {
+            std::mt19937 rng(static_cast<unsigned>(id));
+            for (size_t b = 0; b < batches; ++b)
+            {
+                std::vector<std::pair<void*, size_t>> batch(BATCH);
+                for (auto& item : batch)
+                {
+                    item.second = 8 + rng() % 505;
+                    item.first = timed.allocate(item.second);
+                }
+
+                std::unique_lock<std::mutex> lock(channel.mutex);
+                channel.cv.wait(lock, [&]() { return channel.queue.size() < QUEUE_LIMIT; });
+                channel.queue.push_back(std::move(batch));
+                channel.cv.notify_all();
+            }
+
+            std::lock_guard<std::mutex> lock(channel.mutex);
+            channel.done = true;
+            channel.cv.notify_all();
+        }
+        else
+        {
+            for (;;)
+            {
+                std::unique_lock<std::mutex> lock(channel.mutex);
+                channel.cv.wait(lock, [&]() { return !channel.queue.empty() || channel.done; });
+                if (channel.queue.empty()) break;
+
+                auto batch = std::move(channel.queue.front());
+                channel.queue.pop_front();
+                channel.cv.notify_all();
+                lock.unlock();
+
+                for (auto& item : batch) timed.deallocate(item.first, item.second);
+            }
+        }
+        ctx.merge(timed);
+    });
+}
+
+// 反复分配一个小对象、写入多次再释放；被动伪共享时第一个对象由主线程分配
+static void cacheLoop(RunContext& ctx, bool passive)
+{
+    constexpr size_t SIZE = 8;
+    constexpr size_t WRITES = 1000;
+    const size_t rounds = ctx.iterations(20000);
+
+    // cache-scratch：主线程连续分配的小对象很可能落在同一缓存行，交给各线程先释放
+    std::vector<void*> initial(ctx.threads, nullptr);
+    if (passive)
+    {
+        for (auto& ptr : initial) ptr = ctx.allocator.allocate(SIZE);
+    }
+
+    runThreads(ctx.threads, [&](size_t id)
+    {
+        TimedAllocator timed(ctx.allocator);
+        if (initial[id]) timed.deallocate(initial[id], SIZE);
+
+        for (size_t round = 0; round < rounds; ++round)
+        {
+            volatile char* obj = static_cast<volatile char*>(timed.allocate(SIZE));
+            for (size_t w = 0; w < WRITES; ++w)
+            {
+                obj[w % SIZE] = static_cast<char>(w);
+            }
+            timed.deallocate(const_cast<char*>(obj), SIZE);
+        }
+        ctx.merge(timed);
+    });
+}
+
+static void cacheScratch(RunContext& ctx) { cacheLoop(ctx, true); }
+static void cacheThrash(RunContext& ctx) { cacheLoop(ctx, false); }
+
+// 混合大小：每个线程维持一个存活对象窗口，大小分布偏向小对象，少量超过 MAX_BYTES
+static void mixed(RunContext& ctx)
+{
+    constexpr size_t WINDOW = 1000;
+    const size_t ops = ctx.iterations(200000);
+
+    runThreads(ctx.threads, [&](size_t id)
+    {
+        TimedAllocator timed(ctx.allocator);
+        std::mt19937 rng(static_cast<unsigned>(id + 1));
+        std::vector<std::pair<void*, size_t>> window(WINDOW, {nullptr, 0});
+
+        auto pickSize = [&rng]() -> size_t
+        {
+            unsigned r = rng() % 100;
+            if (r < 70) return 8 + rng() % 121;          // 8B ~ 128B
+            if (r < 95) return 128 + rng() % 3969;       // 128B ~ 4KB
+            if (r < 99) return 4096 + rng() % 61441;     // 4KB ~ 64KB
+            return 65536 + rng() % (448 * 1024 + 1);     // 64KB ~ 512KB
+        };
+
+        for (size_t i = 0; i < ops; ++i)
+        {
+            auto& slot = window[rng() % WINDOW];
+            if (slot.first) timed.deallocate(slot.first, slot.second);
+            slot.second = pickSize();
+            slot.first = timed.allocate(slot.second);
+        }
+        for (auto& slot : window)
+        {
+            if (slot.first) timed.deallocate(slot.first, slot.second);
+        }
+        ctx.merge(timed);
+    });
+}
+
+struct Workload
+{
+    const char* name;
+    void (*run)(RunContext&);
+};
+
+static const Workload WORKLOADS[] = {
+    {"larson", larson},
+    {"threadtest", threadtest},
+    {"xmalloc", xmalloc},
+    {"cache-scratch", cacheScratch},
+    {"cache-thrash", cacheThrash},
+    {"mixed", mixed},
+};
+
+// 当前驻留内存（KB）
+static long currentRssKb()
+{
+    long pages = 0, resident = 0;
+    if (FILE* statm = fopen("/proc/self/statm", "r"))
+    {
+        if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        fclose(statm);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// 在当前进程中运行一个组合，返回 JSON 对象
+static std::string runCase(const Workload& workload, const Allocator& allocator, size_t threads, double scale)
+{
+    RunContext ctx{allocator, threads, scale, {}, {}};
+
+    struct rusage before, after;
+    getrusage(RUSAGE_SELF, &before);
+    auto start = steady_clock::now();
+
+    workload.run(ctx);
+
+#ifdef MEMORY_POOL_INSTRUMENT
+    // 计时编译时输出各层耗时直方图，便于把长尾延迟归到具体的层
+    fprintf(stderr, "== %s / %s / %zu threads ==\n", workload.name, allocator.name, threads);
+    Instrument::dump(stderr);
+#endif
+
+    double seconds = duration<double>(steady_clock::now() - start).count();
+    getrusage(RUSAGE_SELF, &after);
+
+    uint64_t ops = ctx.histogram.count();
+    std::ostringstream json;
+    json << "{\"workload\": \"" << workload.name << "\""
+         << ", \"allocator\": \"" << allocator.name << "\""
+         << ", \"threads\": " << threads
+         << ", \"ops\": " << ops
+         << ", \"seconds\": " << seconds
+         << ", \"ops_per_sec\": " << (seconds > 0 ? ops / seconds : 0)
+         << ", \"p50_ns\": " << ctx.histogram.percentile(0.50)
+         << ", \"p99_ns\": " << ctx.histogram.percentile(0.99)
+         << ", \"p999_ns\": " << ctx.histogram.percentile(0.999)
+         << ", \"peak_rss_kb\": " << after.ru_maxrss
+         << ", \"final_rss_kb\": " << currentRssKb()
+         << ", \"minor_faults\": " << after.ru_minflt - before.ru_minflt
+         << ", \"major_faults\": " << after.ru_majflt - before.ru_majflt
+         << "}";
+    return json.str();
+}
+
+// 在子进程中运行一个组合，通过管道取回结果
+static bool runIsolated(const Workload& workload, const Allocator& allocator, size_t threads,
+                        double scale, std::string& result)
+{
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if (pid == 0)
+    {
+        close(fds[0]);
+        std::string json = runCase(workload, allocator, threads, scale);
+        ssize_t written = write(fds[1], json.data(), json.size());
+        close(fds[1]);
+        _exit(written == static_cast<ssize_t>(json.size()) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    result.clear();
+    char buffer[1024];
+    ssize_t n;
+    while ((n = read(fds[0], buffer, sizeof(buffer))) > 0)
+    {
+        result.append(buffer, n);
+    }
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 && !result.empty();
+}
+
+// 长时间碎片测试
+// 每个周期先分配大量小对象、按随机顺序释放 90%，再对大对象做同样的事；幸存的 10% 保留
+// SURVIVOR_CYCLES 个周期后才释放，它们钉住的 span 使内存无法整块归还。
+// 采样线程按固定间隔记录 /proc/self/statm 的 RSS 和 MemoryPool::getStats() 的各层字节数。
+static int runFragmentation(const Allocator& allocator, double durationSeconds, int intervalMs,
+                            const char* csvPath, double scale)
+{
+    constexpr size_t SURVIVOR_CYCLES = 4;
+    constexpr double SURVIVOR_RATIO = 0.1;
+    const size_t smallCount = std::max<size_t>(1, static_cast<size_t>(200000 * scale));
+    const size_t largeCount = std::max<size_t>(1, static_cast<size_t>(2000 * scale));
+
+    FILE* csv = csvPath ? fopen(csvPath, "w") : stdout;
+    if (!csv)
+    {
+        std::cerr << "cannot write " << csvPath << "\n";
+        return 1;
+    }
+    fprintf(csv, "elapsed_s,cycle,phase,rss_kb,mapped_kb,resident_kb,released_kb,"
+                 "page_cache_free_kb,central_free_kb,thread_cache_kb,live_kb\n");
+
+    // 0 = 小对象阶段，1 = 大对象阶段
+    std::atomic<int> phase{0};
+    std::atomic<size_t> cycle{0};
+    std::atomic<bool> done{false};
+    auto begin = steady_clock::now();
+
+    std::thread sampler([&]()
+    {
+        while (!done.load())
+        {
+            PoolStats stats = MemoryPool::getStats();
+            fprintf(csv, "%.3f,%zu,%s,%ld,%zu,%zu,%zu,%zu,%zu,%zu,%zu\n",
+                    duration<double>(steady_clock::now() - begin).count(),
+                    cycle.load(), phase.load() ? "large" : "small", currentRssKb(),
+                    stats.mappedBytes / 1024, stats.residentBytes / 1024, stats.releasedBytes / 1024,
+                    stats.pageCacheFreeBytes / 1024, stats.centralCacheBytes / 1024,
+                    stats.threadCacheBytes / 1024, stats.liveBytes / 1024);
+            fflush(csv);
+            std::this_thread::sleep_for(milliseconds(intervalMs));
+        }
+    });
+
+    struct Block
+    {
+        void* ptr;
+        size_t size;
+        size_t cycle;
+    };
+    std::vector<Block> survivors;
+    std::mt19937 rng(12345);
+
+    // 分配 count 个对象后随机释放 90%，其余加入幸存者
+    auto runPhase = [&](size_t count, size_t minSize, size_t maxSize)
+    {
+        std::vector<Block> blocks(count);
+        for (auto& block : blocks)
+        {
+            block.size = minSize + rng() % (maxSize - minSize + 1);
+            block.ptr = allocator.allocate(block.size);
+            memset(block.ptr, 0x5a, std::min<size_t>(block.size, 64));
+            block.cycle = cycle.load();
+        }
+
+        std::shuffle(blocks.begin(), blocks.end(), rng);
+        size_t keep = static_cast<size_t>(count * SURVIVOR_RATIO);
+        for (size_t i = keep; i < count; ++i)
+        {
+            allocator.deallocate(blocks[i].ptr, blocks[i].size);
+        }
+        survivors.insert(survivors.end(), blocks.begin(), blocks.begin() + keep);
+    };
+
+    while (duration<double>(steady_clock::now() - begin).count() < durationSeconds)
+    {
+        phase = 0;
+        runPhase(smallCount, 8, 512);
+        phase = 1;
+        runPhase(largeCount, 16 * 1024, 512 * 1024);
+
+        // 释放过老的幸存者
+        size_t current = cycle.fetch_add(1) + 1;
+        auto old = std::partition(survivors.begin(), survivors.end(),
+                                  [&](const Block& b) { return current - b.cycle < SURVIVOR_CYCLES; });
+        for (auto it = old; it != survivors.end(); ++it)
+        {
+            allocator.deallocate(it->ptr, it->size);
+        }
+        survivors.erase(old, survivors.end());
+    }
+
+    for (const Block& block : survivors)
+    {
+        allocator.deallocate(block.ptr, block.size);
+    }
+
+    // 全部释放后再采样一次，观察最终能归还多少
+    std::this_thread::sleep_for(milliseconds(intervalMs));
+    done = true;
+    sampler.join();
+
+    if (csv != stdout) fclose(csv);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    const char* output = nullptr;
+    const char* onlyWorkload = nullptr;
+    const char* onlyAllocator = nullptr;
+    const char* mode = "suite";
+    const char* csvPath = nullptr;
+    double durationSeconds = 120;
+    int intervalMs = 250;
+    size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    double scale = 1.0;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--output") == 0) output = argv[i + 1];
+        else if (strcmp(argv[i], "--workload") == 0) onlyWorkload = argv[i + 1];
+        else if (strcmp(argv[i], "--allocator") == 0) onlyAllocator = argv[i + 1];
+        else if (strcmp(argv[i], "--max-threads") == 0) maxThreads = std::max(1, atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "--scale") == 0) scale = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--mode") == 0) mode = argv[i + 1];
+        else if (strcmp(argv[i], "--duration") == 0) durationSeconds = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--interval") == 0) intervalMs = std::max(1, atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "--csv") == 0) csvPath = argv[i + 1];
+        else
+        {
+            std::cerr << "unknown option " << argv[i] << "\n";
+            return 2;
+        }
+    }
+
+    if (strcmp(mode, "fragmentation") == 0)
+    {
+        const Allocator* allocator = &ALLOCATORS[0];
+        for (const Allocator& candidate : ALLOCATORS)
+        {
+            if (onlyAllocator && strcmp(onlyAllocator, candidate.name) == 0) allocator = &candidate;
+        }
+        return runFragmentation(*allocator, durationSeconds, intervalMs, csvPath, scale);
+    }
+    if (strcmp(mode, "suite") != 0)
+    {
+        std::cerr << "unknown mode " << mode << "\n";
+        return 2;
+    }
+
+    // 线程数：1、2、4 ... 直到核数（核数不是 2 的幂时最后补上核数）
+    std::vector<size_t> threadCounts;
+    for (size_t n = 1; n < maxThreads; n *= 2) threadCounts.push_back(n);
+    threadCounts.push_back(maxThreads);
+
+    std::vector<std::string> results;
+    for (const Workload& workload : WORKLOADS)
+    {
+        if (onlyWorkload && strcmp(onlyWorkload, workload.name) != 0) continue;
+
+        for (size_t threads : threadCounts)
+        {
+            for (const Allocator& allocator : ALLOCATORS)
+            {
+                if (onlyAllocator && strcmp(onlyAllocator, allocator.name) != 0) continue;
+
+                std::string json;
+                if (!runIsolated(workload, allocator, threads, scale, json))
+                {
+                    std::cerr << workload.name << " / " << allocator.name << " / " << threads
+                              << " threads failed\n";
+                    return 1;
+                }
+                std::cerr << json << "\n";
+                results.push_back(json);
+            }
+        }
+    }
+
+    std::ostringstream doc;
+    doc << "{\n  \"cpus\": " << std::thread::hardware_concurrency()
+        << ",\n  \"scale\": " << scale
+        << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        doc << "    " << results[i] << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    doc << "  ]\n}\n";
+
+    if (output)
+    {
+        std::ofstream file(output);
+        file << doc.str();
+        if (!file)
+        {
+            std::cerr << "cannot write " << output << "\n";
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << doc.str();
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "../include/MemoryPool.h" // 包含被测试的内存池类的头文件
+#include <iostream> // 用于控制台输入输出
+#include <vector> // 使用 std::vector 触发容器内部的 new/delete
+#include <string> // 使用 std::string 触发小对象分配
+#include <map> // 使用 std::map 触发节点分配
+#include <thread> // 使用 std::thread 创建和管理线程，用于多线程测试
+#include <cassert> // 使用 assert 宏进行断言
+#include <new> // 使用 std::nothrow 和 std::align_val_t
+
+// 该程序链接 memory_pool_newdelete，所有全局 new/delete 都应由内存池处理
+
+using namespace memoryPool;
+
+void testNewGoesToPool()
+{
+    std::cout << "Running global new test..." << std::endl;
+
+    // 小对象应由内存池分配，页表中能查到其大小类
+    int* value = new int(42);
+    assert(PageCache::getObjectSize(value) == ALIGNMENT);
+    delete value;
+
+    char* buffer = new char[100];
+    assert(PageCache::getObjectSize(buffer) == SizeClass::roundUp(100));
+    delete[] buffer;
+
+    // 超过 MAX_BYTES 的对象由系统分配
+    char* large = new char[MAX_BYTES + 1];
+    assert(PageCache::getObjectSize(large) == 0);
+    delete[] large;
+
+    std::cout << "Global new test passed!" << std::endl;
+}
+
+void testAlignedAndNothrow()
+{
+    std::cout << "Running aligned and nothrow new test..." << std::endl;
+
+    struct alignas(64) CacheLine
+    {
+        char data[64];
+    };
+
+    std::vector<CacheLine*> lines;
+    for (int i = 0; i < 100; ++i)
+    {
+        CacheLine* line = new CacheLine;
+        assert((reinterpret_cast<uintptr_t>(line) & 63) == 0);
+        lines.push_back(line);
+    }
+    for (CacheLine* line : lines)
+    {
+        delete line;
+    }
+
+    // 超过一页的对齐交给系统分配
+    void* page = operator new(100, std::align_val_t(8192));
+    assert((reinterpret_cast<uintptr_t>(page) & 8191) == 0);
+    operator delete(page, std::align_val_t(8192));
+
+    int* noThrow = new (std::nothrow) int[16];
+    assert(noThrow != nullptr);
+    delete[] noThrow;
+
+    // delete 空指针必须安全
+    int* null = nullptr;
+    delete null;
+
+    std::cout << "Aligned and nothrow new test passed!" << std::endl;
+}
+
+void testContainers()
+{
+    std::cout << "Running container test..." << std::endl;
+
+    const int NUM_THREADS = 4;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t)
+    {
+        threads.emplace_back([t]()
+        {
+            std::map<int, std::string> map;
+            for (int i = 0; i < 10000; ++i)
+            {
+                map[i] = std::string(i % 64 + 1, static_cast<char>('a' + t));
+            }
+            for (int i = 0; i < 10000; i += 2)
+            {
+                map.erase(i);
+            }
+            for ([[maybe_unused]] const auto& [key, value] : map)
+            {
+                assert(value.size() == static_cast<size_t>(key % 64 + 1));
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::cout << "Container test passed!" << std::endl;
+}
+
+int main()
+{
+    std::cout << "Starting global new/delete tests..." << std::endl;
+
+    testNewGoesToPool();
+    testAlignedAndNothrow();
+    testContainers();
+
+    std::cout << "All tests passed successfully!" << std::endl;
+    return 0;
+}
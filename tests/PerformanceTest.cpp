@@ -1,10 +1,27 @@
 #include "../include/MemoryPool.h" // 包含被测试的内存池类的头文件
+#include "../include/PoolAllocator.h" // 包含标准库分配器适配器，用于容器测试
+#include "../include/Arena.h" // 单调内存区测试
+#include "../include/PersistentHeap.h" // 持久化堆测试
+#include "../include/PageCache.h" // 页缓存补充吞吐测试
+#include "../include/Heap.h" // 缓存着色测试
 #include <iostream> // 用于控制台输入输出
 #include <vector> // 使用 std::vector 存储动态数组，用于保存分配的内存指针
 #include <chrono> // 使用 std::chrono 库进行时间测量
 #include <random> // 用于生成随机数，用于模拟不同大小的内存分配
+#include <algorithm> // 缓存着色测试中打乱访问顺序
 #include <iomanip> // 用于格式化输出，例如设置精度
 #include <thread> // 使用 std::thread 创建和管理线程，用于多线程性能测试
+#include <map> // 节点容器测试
+#include <list> // 节点容器测试
+#include <unordered_map> // 节点容器测试
+#include <cstring> // 预热测试中写入内存块
+#include <csignal> // 实时模式测试中的停止标记
+#include <unistd.h> // 实时模式测试中的 fork 和管道
+#include <sys/ptrace.h> // 实时模式测试中统计子进程的系统调用
+#include <sys/resource.h> // 实时模式测试中统计缺页次数
+#include <sys/mman.h> // 实时模式测试中锁定子进程的页面
+#include <sys/wait.h> // 实时模式测试中等待子进程
+#include <malloc.h> // 实时模式测试中归还 malloc 的空闲内存
 
 using namespace memoryPool; // 假设 MemoryPool 类位于 Kama_memoryPool 命名空间中，方便直接使用
 using namespace std::chrono; // 方便使用 std::chrono 命名空间下的类型，如 high_resolution_clock
@@ -98,6 +115,32 @@ public:
                       << t.elapsed() << " ms" << std::endl; // 输出内存池分配和释放花费的时间
         }
 
+        // 测试内存池（编译期大小类别）
+        {
+            Timer t; // 创建计时器对象
+            std::vector<void*> ptrs; // 存储分配的内存指针
+            ptrs.reserve(NUM_ALLOCS); // 预先分配足够的空间
+
+            for (size_t i = 0; i < NUM_ALLOCS; ++i)
+            {
+                ptrs.push_back(MemoryPool::allocate<SMALL_SIZE>()); // 大小类别索引在编译期求出
+
+                if (i % 4 == 0) // 每分配 4 次，释放一次
+                {
+                    MemoryPool::deallocate<SMALL_SIZE>(ptrs.back());
+                    ptrs.pop_back();
+                }
+            }
+
+            for (void* ptr : ptrs) // 释放剩余所有已分配的内存
+            {
+                MemoryPool::deallocate<SMALL_SIZE>(ptr);
+            }
+
+            std::cout << "Memory Pool (constexpr): " << std::fixed << std::setprecision(3)
+                      << t.elapsed() << " ms" << std::endl;
+        }
+
         // 测试new/delete
         {
             Timer t; // 创建计时器对象
@@ -294,6 +337,514 @@ public:
                       << t.elapsed() << " ms" << std::endl; // 输出 new/delete 的性能
         }
     }
+
+    // 5. 批量分配测试：一次性分配、释放大量同大小的节点
+    static void testBatchAllocation()
+    {
+        constexpr size_t BATCH = 10000; // 每批内存块数量
+        constexpr size_t ROUNDS = 20; // 批次数
+        constexpr size_t NODE_SIZE = 48; // 节点大小
+
+        std::cout << "\nTesting batch allocations (" << ROUNDS << " rounds of "
+                  << BATCH << " x " << NODE_SIZE << " bytes):" << std::endl;
+
+        std::vector<void*> ptrs(BATCH);
+
+        // 逐个分配/释放
+        {
+            Timer t;
+            for (size_t round = 0; round < ROUNDS; ++round)
+            {
+                for (size_t i = 0; i < BATCH; ++i)
+                {
+                    ptrs[i] = MemoryPool::allocate(NODE_SIZE);
+                }
+                for (size_t i = 0; i < BATCH; ++i)
+                {
+                    MemoryPool::deallocate(ptrs[i], NODE_SIZE);
+                }
+            }
+            std::cout << "Memory Pool (single): " << std::fixed << std::setprecision(3)
+                      << t.elapsed() << " ms" << std::endl;
+        }
+
+        // 批量分配/释放
+        {
+            Timer t;
+            for (size_t round = 0; round < ROUNDS; ++round)
+            {
+                MemoryPool::allocateBatch(NODE_SIZE, BATCH, ptrs.data());
+                MemoryPool::deallocateBatch(NODE_SIZE, BATCH, ptrs.data());
+            }
+            std::cout << "Memory Pool (batch): " << std::fixed << std::setprecision(3)
+                      << t.elapsed() << " ms" << std::endl;
+        }
+    }
+
+    // 6. 节点容器测试：反复插入、删除节点，比较 std::allocator 与 PoolAllocator / pmr
+    static void testArena()
+    {
+        constexpr size_t REQUESTS = 2000; // 模拟的请求数
+        constexpr size_t OBJECTS = 200; // 每个请求分配的对象数
+
+        std::cout << "\nTesting request-scoped allocations (" << REQUESTS << " requests of "
+                  << OBJECTS << " objects, 16-256 bytes):" << std::endl;
+
+        std::mt19937 rng(42);
+        std::vector<size_t> sizes(OBJECTS);
+        for (size_t& size : sizes) size = 16 + rng() % 241;
+        std::vector<void*> ptrs(OBJECTS);
+
+        // 逐个分配，请求结束时逐个释放
+        {
+            Timer t;
+            for (size_t request = 0; request < REQUESTS; ++request)
+            {
+                for (size_t i = 0; i < OBJECTS; ++i)
+                {
+                    ptrs[i] = MemoryPool::allocate(sizes[i]);
+                }
+                for (size_t i = 0; i < OBJECTS; ++i)
+                {
+                    MemoryPool::deallocate(ptrs[i], sizes[i]);
+                }
+            }
+            std::cout << "Memory Pool: " << std::fixed << std::setprecision(3)
+                      << t.elapsed() << " ms" << std::endl;
+        }
+
+        // 在内存区中分配，请求结束时整体 reset
+        {
+            Arena arena;
+            Timer t;
+            for (size_t request = 0; request < REQUESTS; ++request)
+            {
+                for (size_t i = 0; i < OBJECTS; ++i)
+                {
+                    ptrs[i] = arena.allocate(sizes[i]);
+                }
+                arena.reset();
+            }
+            std::cout << "Arena:       " << std::fixed << std::setprecision(3)
+                      << t.elapsed() << " ms" << std::endl;
+        }
+    }
+
+    // 重启测试：在持久化堆中建立索引后关闭，比较重新建立索引与重新打开堆的耗时
+    static void testPersistentRestart()
+    {
+        constexpr size_t ENTRIES = 200000;
+        std::cout << "\nTesting restart with a persistent heap (" << ENTRIES << " entries):" << std::endl;
+
+        struct Entry
+        {
+            Entry* next;
+            uint64_t key;
+            char value[48];
+        };
+
+        char path[] = "/tmp/memory_pool_perfXXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0) return;
+        close(fd);
+
+        {
+            auto heap = PersistentHeap::open(path, 64 * 1024 * 1024);
+            if (!heap)
+            {
+                std::cout << "skipped (cannot map the heap)" << std::endl;
+                unlink(path);
+                return;
+            }
+
+            Timer t;
+            Entry* head = nullptr;
+            for (size_t i = 0; i < ENTRIES; ++i)
+            {
+                Entry* entry = static_cast<Entry*>(heap->allocate(sizeof(Entry)));
+                entry->next = head;
+                entry->key = i * 2654435761u;
+                memset(entry->value, static_cast<int>(i), sizeof(entry->value));
+                head = entry;
+            }
+            heap->setRoot(head);
+            std::cout << "Rebuild: " << std::fixed << std::setprecision(3) << t.elapsed() << " ms" << std::endl;
+        }
+
+        {
+            Timer t;
+            auto heap = PersistentHeap::open(path, 0);
+            void* root = heap ? heap->root() : nullptr;
+            double opened = t.elapsed();
+
+            // 首次遍历从文件页缓存映射页面
+            size_t count = 0;
+            for (Entry* entry = static_cast<Entry*>(root); entry; entry = entry->next) ++count;
+            std::cout << "Reopen:  " << std::fixed << std::setprecision(3) << opened << " ms (first traversal of "
+                      << count << " entries " << t.elapsed() - opened << " ms)" << std::endl;
+        }
+        unlink(path);
+    }
+
+    // 冷启动测试：新线程的第一批分配，未预热时每个大小类别都要进入慢速路径并首次写入新切分的页面
+    static void testPrewarm()
+    {
+        constexpr size_t CLASSES = 8;
+        constexpr size_t BLOCKS = 64;
+        std::cout << "\nTesting first allocations in a new thread (" << CLASSES << " classes x "
+                  << BLOCKS << " blocks):" << std::endl;
+
+        // 两个线程使用不同（且之前未用过）的大小，都从空的中心缓存开始
+        auto firstRequest = [](size_t base, bool prewarm)
+        {
+            double elapsed = 0;
+            std::thread worker([&]
+            {
+                std::vector<std::pair<void*, size_t>> ptrs;
+                if (prewarm)
+                {
+                    for (size_t c = 0; c < CLASSES; ++c) MemoryPool::reserve(base << c, BLOCKS);
+                }
+
+                Timer t;
+                for (size_t c = 0; c < CLASSES; ++c)
+                {
+                    for (size_t i = 0; i < BLOCKS; ++i)
+                    {
+                        size_t size = base << c;
+                        void* ptr = MemoryPool::allocate(size);
+                        memset(ptr, 1, size);
+                        ptrs.emplace_back(ptr, size);
+                    }
+                }
+                elapsed = t.elapsed();
+
+                for (const auto& [ptr, size] : ptrs) MemoryPool::deallocate(ptr, size);
+            });
+            worker.join();
+            return elapsed;
+        };
+
+        std::cout << "Cold:      " << std::fixed << std::setprecision(3) << firstRequest(40, false) << " ms" << std::endl;
+        std::cout << "Prewarmed: " << std::fixed << std::setprecision(3) << firstRequest(56, true) << " ms" << std::endl;
+    }
+
+    // 页缓存补充吞吐：多个线程直接向页缓存申请和归还 span，每个线程模拟一个大小类别的中心缓存补充，
+    // 线程数增加时各类别落在不同分片，吞吐应随核数增长（单核机器上只能看到加锁开销不随线程数上升）
+    static void testPageCacheScaling()
+    {
+        constexpr size_t OPS_PER_THREAD = 20000;
+        constexpr size_t BATCH = 16;
+        std::cout << "\nTesting page cache refill throughput (" << OPS_PER_THREAD
+                  << " span allocations per thread):" << std::endl;
+
+        for (size_t threadCount : {1, 2, 4, 8})
+        {
+            Timer t;
+            std::vector<std::thread> threads;
+            for (size_t i = 0; i < threadCount; ++i)
+            {
+                threads.emplace_back([i]
+                {
+                    PageCache& pageCache = PageCache::getInstance();
+                    size_t objSize = (i + 1) * 64; // 每个线程一个大小类别
+                    void* spans[BATCH];
+                    for (size_t op = 0; op < OPS_PER_THREAD; op += BATCH)
+                    {
+                        for (size_t k = 0; k < BATCH; ++k)
+                        {
+                            spans[k] = pageCache.allocateSpan(1 + k % 4, objSize);
+                        }
+                        for (size_t k = 0; k < BATCH; ++k)
+                        {
+                            pageCache.deallocateSpan(spans[k], 1 + k % 4);
+                        }
+                    }
+                });
+            }
+            for (auto& thread : threads) thread.join();
+
+            double elapsed = t.elapsed();
+            std::cout << threadCount << " threads: " << std::fixed << std::setprecision(3)
+                      << elapsed << " ms, "
+                      << std::setprecision(0) << threadCount * OPS_PER_THREAD / elapsed << " spans/ms" << std::endl;
+        }
+    }
+
+    // 缓存着色：沿指针链依次访问每个对象的第一个缓存行。对象大小为 4KB + 64，
+    // 不着色时各 slab 的第 i 个对象落在同一个 L1 组上，对象数超过组相联度后互相驱逐；
+    // 对照组按着色之前的布局在页对齐的 span 中从起点切分同样多的对象
+    static void testCacheColoring()
+    {
+        constexpr size_t SIZE = 4096 + 64;
+        constexpr size_t SPANS = 64;
+        constexpr size_t SPAN_BYTES = 8 * 4096;
+        constexpr size_t PER_SPAN = SPAN_BYTES / SIZE;
+        constexpr size_t COUNT = SPANS * PER_SPAN;
+        constexpr size_t ROUNDS = 20000;
+        std::cout << "\nTesting strided access over " << COUNT << " objects of " << SIZE
+                  << " bytes (" << ROUNDS << " rounds):" << std::endl;
+
+        // 不着色的布局
+        char* plain = static_cast<char*>(mmap(nullptr, SPANS * SPAN_BYTES, PROT_READ | PROT_WRITE,
+                                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        std::vector<void*> uncolored;
+        for (size_t span = 0; span < SPANS; ++span)
+        {
+            for (size_t i = 0; i < PER_SPAN; ++i) uncolored.push_back(plain + span * SPAN_BYTES + i * SIZE);
+        }
+
+        // 内存池分配（独立堆，类别的颜色从头轮换）
+        Heap heap;
+        std::vector<void*> pooled;
+        for (size_t i = 0; i < COUNT; ++i) pooled.push_back(heap.allocate(SIZE));
+
+        auto chase = [](std::vector<void*> objects, const char* label)
+        {
+            // 相同的随机顺序串成环，每次访问依赖上一次的结果，排除预取和并行访存
+            std::mt19937 gen(42);
+            std::shuffle(objects.begin(), objects.end(), gen);
+            for (size_t i = 0; i < objects.size(); ++i)
+            {
+                *static_cast<void**>(objects[i]) = objects[(i + 1) % objects.size()];
+            }
+
+            std::vector<bool> sets(64);
+            for (void* object : objects) sets[(reinterpret_cast<uintptr_t>(object) >> 6) & 63] = true;
+
+            void* current = objects[0];
+            Timer t;
+            for (size_t i = 0; i < ROUNDS * objects.size(); ++i) current = *static_cast<void**>(current);
+            double elapsed = t.elapsed();
+
+            chaseSink = current; // 写入 volatile 变量，保证循环不被优化掉
+
+            std::cout << label << std::fixed << std::setprecision(3) << elapsed / (ROUNDS * objects.size()) * 1e6
+                      << " ns per access, " << std::count(sets.begin(), sets.end(), true) << " of 64 L1 sets" << std::endl;
+        };
+
+        chase(uncolored, "Uncolored:   ");
+        chase(pooled,    "Memory Pool: ");
+
+        for (void* ptr : pooled) heap.deallocate(ptr, SIZE);
+        munmap(plain, SPANS * SPAN_BYTES);
+    }
+
+    // 实时模式测试：分别在默认模式和实时模式下运行同一段分配负载，统计其间的缺页和系统调用次数。
+    // 负载在 fork 出的子进程中运行，父进程用 ptrace 统计子进程在两个 SIGSTOP 标记之间的系统调用，
+    // 子进程用 getrusage 统计同一区间的缺页，经管道交给父进程输出
+    static void testRealtime()
+    {
+        std::cout << "\nTesting realtime mode (faults and syscalls during "
+                  << REALTIME_ROUNDS << " rounds of allocations):" << std::endl;
+        runRealtimeChild(false, "Default mode: ");
+        runRealtimeChild(true,  "Realtime mode:");
+    }
+
+private:
+    static constexpr size_t REALTIME_ROUNDS = 20000;
+    static inline void* volatile chaseSink = nullptr;
+
+    static void runRealtimeChild(bool realtime, const char* label)
+    {
+        int fds[2];
+        if (pipe(fds) != 0) return;
+        std::cout.flush();
+
+        pid_t pid = fork();
+        if (pid < 0) return;
+        if (pid == 0)
+        {
+            close(fds[0]);
+            realtimeWorkload(realtime, fds[1]);
+            _exit(0);
+        }
+        close(fds[1]);
+
+        long syscalls = traceSyscalls(pid);
+        long faults = -1;
+        if (read(fds[0], &faults, sizeof(faults)) != sizeof(faults)) faults = -1;
+        close(fds[0]);
+
+        if (syscalls < 0 || faults < 0)
+        {
+            std::cout << label << " skipped (ptrace unavailable)" << std::endl;
+            return;
+        }
+        std::cout << label << " page faults " << faults << ", syscalls " << syscalls << std::endl;
+    }
+
+    // 子进程：进入实时模式（可选），然后在两个标记之间运行负载
+    static void realtimeWorkload(bool realtime, int out)
+    {
+        if (ptrace(PTRACE_TRACEME, 0, nullptr, nullptr) != 0) _exit(1);
+        raise(SIGSTOP); // 等待父进程设置跟踪选项
+
+        // 各大小类别同时存活的对象不超过线程缓存的容量，稳定后全部在线程缓存中周转
+        const size_t sizes[] = {72, 264, 2056, 16392};
+        const size_t LARGE = 1024 * 1024;
+
+        if (realtime)
+        {
+            RealtimeConfig config;
+            config.heapBytes = 16 * 1024 * 1024;
+            for (size_t size : sizes) config.classes.push_back({size, 64});
+            if (!MemoryPool::enterRealtime(config)) _exit(1);
+        }
+
+        void* ptrs[4][32];
+        rusage before, after;
+        // 子进程与父进程写时复制共享页面，首次写入继承来的元数据和栈也会缺页；
+        // 与常见的实时进程一样先锁定当前全部页面，使两种模式下统计到的只有分配本身引起的缺页
+        mlockall(MCL_CURRENT);
+        if (!realtime)
+        {
+            // 默认模式下再归还从父进程继承的空闲内存，与刚启动的进程一样从冷状态开始，不受前面测试的影响
+            munlockall();
+            MemoryPool::releaseFreeMemory();
+            malloc_trim(0);
+        }
+        getrusage(RUSAGE_SELF, &before);
+
+        raise(SIGSTOP); // 空区间，用于扣除标记本身的系统调用
+        raise(SIGSTOP);
+        for (size_t round = 0; round < REALTIME_ROUNDS; ++round)
+        {
+            for (size_t c = 0; c < 4; ++c)
+            {
+                for (void*& ptr : ptrs[c])
+                {
+                    ptr = MemoryPool::allocate(sizes[c]);
+                    static_cast<char*>(ptr)[0] = 1;
+                    static_cast<char*>(ptr)[sizes[c] - 1] = 1;
+                }
+            }
+            for (size_t c = 0; c < 4; ++c)
+            {
+                for (void* ptr : ptrs[c]) MemoryPool::deallocate(ptr, sizes[c]);
+            }
+            if (round % 64 == 0)
+            {
+                char* large = static_cast<char*>(MemoryPool::allocate(LARGE));
+                for (size_t i = 0; i < LARGE; i += PageCache::PAGE_SIZE) large[i] = 1;
+                MemoryPool::deallocate(large, LARGE);
+            }
+        }
+        raise(SIGSTOP);
+
+        getrusage(RUSAGE_SELF, &after);
+        long faults = (after.ru_minflt - before.ru_minflt) + (after.ru_majflt - before.ru_majflt);
+        if (write(out, &faults, sizeof(faults)) != sizeof(faults)) _exit(1);
+    }
+
+    // 父进程：统计子进程每个标记区间内的系统调用，返回负载区间扣除空区间后的次数，无法跟踪时返回 -1
+    static long traceSyscalls(pid_t pid)
+    {
+        int status;
+        if (waitpid(pid, &status, 0) != pid || !WIFSTOPPED(status)) return -1;
+        ptrace(PTRACE_SETOPTIONS, pid, nullptr, PTRACE_O_TRACESYSGOOD | PTRACE_O_EXITKILL);
+
+        long stops[4] = {}; // 每个区间的系统调用停止次数，进入和退出各一次
+        size_t marker = 0;
+        ptrace(PTRACE_SYSCALL, pid, nullptr, nullptr);
+        while (waitpid(pid, &status, 0) == pid && WIFSTOPPED(status))
+        {
+            int sig = WSTOPSIG(status);
+            if (sig == (SIGTRAP | 0x80))
+            {
+                if (marker < 4) stops[marker]++;
+                sig = 0;
+            }
+            else if (sig == SIGSTOP)
+            {
+                ++marker;
+                sig = 0;
+            }
+            ptrace(PTRACE_SYSCALL, pid, nullptr, sig);
+        }
+        if (marker < 3) return -1;
+
+        // 区间 1 是空区间，区间 2 是负载
+        return (stops[2] - stops[1]) / 2;
+    }
+
+public:
+    static void testNodeContainers()
+    {
+        constexpr int NUM_KEYS = 20000; // 每轮插入的键数量
+        constexpr int NUM_ROUNDS = 10; // 插入/删除的轮数
+
+        std::cout << "\nTesting node container churn (" << NUM_ROUNDS << " rounds of "
+                  << NUM_KEYS << " keys):" << std::endl;
+
+        // 每轮插入全部键，再删除一半，最后清空
+        auto churn = [](auto& container, auto insert)
+        {
+            for (int round = 0; round < NUM_ROUNDS; ++round)
+            {
+                for (int i = 0; i < NUM_KEYS; ++i)
+                {
+                    insert(container, i);
+                }
+                bool erase = true; // 隔一个删一个
+                for (auto it = container.begin(); it != container.end(); erase = !erase)
+                {
+                    it = erase ? container.erase(it) : std::next(it);
+                }
+                container.clear();
+            }
+        };
+
+        auto report = [](const char* name, double stdTime, double poolTime, double pmrTime)
+        {
+            std::cout << std::left << std::setw(15) << name << std::fixed << std::setprecision(3)
+                      << "std::allocator: " << stdTime << " ms, "
+                      << "PoolAllocator: " << poolTime << " ms, "
+                      << "pmr: " << pmrTime << " ms" << std::endl;
+        };
+
+        auto mapInsert = [](auto& m, int i) { m.emplace(i, i); };
+        auto listInsert = [](auto& l, int i) { l.push_back(i); };
+
+        std::pmr::memory_resource* resource = PoolMemoryResource::getInstance();
+
+        // std::map
+        {
+            std::map<int, int> stdMap;
+            std::map<int, int, std::less<int>, PoolAllocator<std::pair<const int, int>>> poolMap;
+            std::pmr::map<int, int> pmrMap(resource);
+
+            Timer t1; churn(stdMap, mapInsert); double stdTime = t1.elapsed();
+            Timer t2; churn(poolMap, mapInsert); double poolTime = t2.elapsed();
+            Timer t3; churn(pmrMap, mapInsert); double pmrTime = t3.elapsed();
+            report("std::map", stdTime, poolTime, pmrTime);
+        }
+
+        // std::list
+        {
+            std::list<int> stdList;
+            std::list<int, PoolAllocator<int>> poolList;
+            std::pmr::list<int> pmrList(resource);
+
+            Timer t1; churn(stdList, listInsert); double stdTime = t1.elapsed();
+            Timer t2; churn(poolList, listInsert); double poolTime = t2.elapsed();
+            Timer t3; churn(pmrList, listInsert); double pmrTime = t3.elapsed();
+            report("std::list", stdTime, poolTime, pmrTime);
+        }
+
+        // std::unordered_map
+        {
+            std::unordered_map<int, int> stdHash;
+            std::unordered_map<int, int, std::hash<int>, std::equal_to<int>,
+                               PoolAllocator<std::pair<const int, int>>> poolHash;
+            std::pmr::unordered_map<int, int> pmrHash(resource);
+
+            Timer t1; churn(stdHash, mapInsert); double stdTime = t1.elapsed();
+            Timer t2; churn(poolHash, mapInsert); double poolTime = t2.elapsed();
+            Timer t3; churn(pmrHash, mapInsert); double pmrTime = t3.elapsed();
+            report("unordered_map", stdTime, poolTime, pmrTime);
+        }
+    }
 };
 
 int main()
@@ -307,6 +858,14 @@ int main()
     PerformanceTest::testSmallAllocation(); // 测试小对象分配的性能
     PerformanceTest::testMultiThreaded(); // 测试多线程环境下的性能
     PerformanceTest::testMixedSizes(); // 测试混合大小对象分配的性能
+    PerformanceTest::testBatchAllocation(); // 测试批量分配的性能
+    PerformanceTest::testArena(); // 测试单调内存区的性能
+    PerformanceTest::testNodeContainers(); // 测试节点容器的性能
+    PerformanceTest::testPersistentRestart(); // 测试持久化堆的重启耗时
+    PerformanceTest::testPrewarm(); // 测试预热对新线程首批分配的影响
+    PerformanceTest::testPageCacheScaling(); // 测试页缓存补充吞吐随线程数的变化
+    PerformanceTest::testCacheColoring(); // 测试缓存着色对跨步访问的影响
+    PerformanceTest::testRealtime(); // 测试实时模式下的缺页和系统调用
 
     return 0; // 程序结束
 }
@@ -0,0 +1,233 @@
+#include "../include/MemoryPool.h" // 被比较的内存池
+#include "../include/AllocTrace.h" // 轨迹日志格式
+#include <iostream> // 控制台输出
+#include <iomanip> // 格式化输出
+#include <vector> // 重放操作序列
+#include <string> // 分配器名称
+#include <functional> // 分配器接口
+#include <unordered_map> // 原地址到槽位的映射
+#include <algorithm> // 排序、百分位数
+#include <chrono> // 计时
+#include <cstring> // strcmp
+#include <dlfcn.h> // 动态加载其他分配器
+#include <sys/resource.h> // 峰值 RSS
+#include <sys/wait.h> // 等待子进程
+#include <unistd.h> // fork
+
+using namespace memoryPool;
+using namespace std::chrono;
+
+// 轨迹重放工具
+// 读取 AllocTrace 记录的日志，按时间戳顺序在单线程中依次重放到各个分配器上：
+// 本内存池、glibc malloc，以及通过 dlopen 找到的其他分配器（jemalloc、tcmalloc、mimalloc 或 --lib 指定）。
+// 每个分配器在独立的子进程中重放，峰值 RSS 互不影响。
+//
+// 用法: trace_replay <trace.log> [--lib 名称:路径:分配函数:释放函数]...
+
+// 重放的一步操作，地址已换算成槽位编号
+struct ReplayOp
+{
+    uint32_t slot;
+    uint32_t size;
+    bool     alloc;
+};
+
+// 被测分配器
+struct Backend
+{
+    std::string name;
+    std::function<void*(size_t)> allocate;
+    std::function<void(void*, size_t)> deallocate;
+};
+
+// 把日志转换为按时间排序的操作序列
+// 释放未在日志中分配过的地址（记录开始前分配的对象）会被跳过
+static std::vector<ReplayOp> buildOps(std::vector<AllocTrace::Event>& events, size_t& numSlots)
+{
+    std::stable_sort(events.begin(), events.end(),
+                     [](const AllocTrace::Event& a, const AllocTrace::Event& b)
+                     { return a.timestamp < b.timestamp; });
+
+    std::vector<ReplayOp> ops;
+    ops.reserve(events.size());
+    std::unordered_map<uint64_t, std::pair<uint32_t, uint32_t>> live; // 地址 -> (槽位, 大小)
+    numSlots = 0;
+
+    for (const AllocTrace::Event& event : events)
+    {
+        if (event.op == AllocTrace::OP_ALLOC)
+        {
+            uint32_t slot = static_cast<uint32_t>(numSlots++);
+            live[event.ptr] = {slot, event.size};
+            ops.push_back({slot, event.size, true});
+        }
+        else if (event.op == AllocTrace::OP_FREE)
+        {
+            auto it = live.find(event.ptr);
+            if (it == live.end()) continue;
+            ops.push_back({it->second.first, it->second.second, false});
+            live.erase(it);
+        }
+    }
+    return ops;
+}
+
+// 在当前进程中重放并输出一行结果
+static void replay(const Backend& backend, const std::vector<ReplayOp>& ops, size_t numSlots)
+{
+    std::vector<void*> slots(numSlots, nullptr);
+    std::vector<uint32_t> latencies(ops.size());
+
+    auto begin = steady_clock::now();
+    for (size_t i = 0; i < ops.size(); ++i)
+    {
+        const ReplayOp& op = ops[i];
+        auto start = steady_clock::now();
+        if (op.alloc)
+        {
+            void* ptr = backend.allocate(op.size);
+            if (ptr && op.size) *static_cast<char*>(ptr) = 1; // 模拟使用，触及首字节
+            slots[op.slot] = ptr;
+        }
+        else
+        {
+            backend.deallocate(slots[op.slot], op.size);
+            slots[op.slot] = nullptr;
+        }
+        latencies[i] = static_cast<uint32_t>(duration_cast<nanoseconds>(steady_clock::now() - start).count());
+    }
+    double seconds = duration<double>(steady_clock::now() - begin).count();
+
+    // 释放日志结束时仍存活的对象（不计时）
+    for (size_t i = 0; i < ops.size(); ++i)
+    {
+        if (ops[i].alloc && slots[ops[i].slot])
+        {
+            backend.deallocate(slots[ops[i].slot], ops[i].size);
+            slots[ops[i].slot] = nullptr;
+        }
+    }
+
+    auto percentile = [&latencies](double p) -> uint32_t
+    {
+        if (latencies.empty()) return 0;
+        size_t k = std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()));
+        std::nth_element(latencies.begin(), latencies.begin() + k, latencies.end());
+        return latencies[k];
+    };
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    std::cout << std::left << std::setw(12) << backend.name << std::right
+              << std::setw(14) << std::fixed << std::setprecision(0) << (seconds > 0 ? ops.size() / seconds : 0)
+              << std::setw(10) << percentile(0.50)
+              << std::setw(10) << percentile(0.99)
+              << std::setw(10) << percentile(0.999)
+              << std::setw(14) << usage.ru_maxrss / 1024.0 << std::endl;
+}
+
+// 通过 dlopen 加载一个分配器，找不到时返回 false
+static bool loadBackend(const std::string& name, const char* path, const char* allocSym,
+                        const char* freeSym, std::vector<Backend>& backends)
+{
+    void* handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!handle) return false;
+
+    auto allocFn = reinterpret_cast<void* (*)(size_t)>(dlsym(handle, allocSym));
+    auto freeFn = reinterpret_cast<void (*)(void*)>(dlsym(handle, freeSym));
+    if (!allocFn || !freeFn)
+    {
+        dlclose(handle);
+        return false;
+    }
+
+    backends.push_back({name, allocFn, [freeFn](void* ptr, size_t) { freeFn(ptr); }});
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <trace.log> [--lib name:path:malloc:free]...\n";
+        return 2;
+    }
+
+    std::vector<AllocTrace::Event> events;
+    if (!AllocTrace::readLog(argv[1], events))
+    {
+        std::cerr << "cannot read trace " << argv[1] << "\n";
+        return 1;
+    }
+
+    size_t numSlots = 0;
+    std::vector<ReplayOp> ops = buildOps(events, numSlots);
+    std::cout << "Replaying " << ops.size() << " operations (" << numSlots << " allocations) from "
+              << argv[1] << "\n";
+
+    std::vector<Backend> backends;
+    backends.push_back({"memory_pool",
+                        [](size_t size) { return MemoryPool::allocate(size); },
+                        [](void* ptr, size_t size) { MemoryPool::deallocate(ptr, size); }});
+    backends.push_back({"glibc",
+                        [](size_t size) { return malloc(size); },
+                        [](void* ptr, size_t) { free(ptr); }});
+
+    // 机器上常见的其他分配器
+    loadBackend("jemalloc", "libjemalloc.so.2", "malloc", "free", backends);
+    loadBackend("tcmalloc", "libtcmalloc_minimal.so.4", "tc_malloc", "tc_free", backends) ||
+        loadBackend("tcmalloc", "libtcmalloc.so.4", "tc_malloc", "tc_free", backends);
+    loadBackend("mimalloc", "libmimalloc.so.2", "mi_malloc", "mi_free", backends);
+
+    // 命令行指定的分配器
+    for (int i = 2; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--lib") != 0) continue;
+
+        std::string spec = argv[i + 1];
+        std::vector<std::string> parts;
+        size_t pos = 0, next;
+        while ((next = spec.find(':', pos)) != std::string::npos)
+        {
+            parts.push_back(spec.substr(pos, next - pos));
+            pos = next + 1;
+        }
+        parts.push_back(spec.substr(pos));
+
+        if (parts.size() != 4 ||
+            !loadBackend(parts[0], parts[1].c_str(), parts[2].c_str(), parts[3].c_str(), backends))
+        {
+            std::cerr << "cannot load allocator " << spec << "\n";
+        }
+    }
+
+    std::cout << std::left << std::setw(12) << "allocator" << std::right
+              << std::setw(14) << "ops/s" << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns"
+              << std::setw(10) << "p99.9 ns" << std::setw(14) << "peak RSS MiB" << std::endl;
+    std::cout.flush();
+
+    for (const Backend& backend : backends)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            replay(backend, ops, numSlots);
+            std::cout.flush();
+            _exit(0);
+        }
+        if (pid < 0)
+        {
+            std::cerr << "fork failed\n";
+            return 1;
+        }
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            std::cout << std::left << std::setw(12) << backend.name << " failed" << std::endl;
+        }
+    }
+    return 0;
+}
@@ -1,4 +1,12 @@
 #include "../include/MemoryPool.h" // 包含被测试的内存池类的头文件
+#include "../include/PoolAllocator.h" // 包含标准库分配器适配器
+#include "../include/ObjectPool.h" // 包含类型化对象池
+#include "../include/HeapProfiler.h" // 包含采样堆分析器
+#include "../include/AllocTrace.h" // 包含分配轨迹记录器
+#include "../include/Instrument.h" // 包含分层计时直方图
+#include "../include/Heap.h" // 包含独立堆
+#include "../include/Arena.h" // 包含单调内存区
+#include "../include/PageCache.h" // 包含页缓存（分片测试直接申请 span）
 #include <iostream> // 用于控制台输入输出
 #include <vector> // 使用 std::vector 存储动态数组
 #include <thread> // 使用 std::thread 创建和管理线程，用于多线程测试
@@ -7,6 +15,15 @@
 #include <random> // 用于生成随机数，用于压力测试和多线程测试
 #include <algorithm> // 包含 std::shuffle 等算法，用于打乱容器中的元素
 #include <atomic> // 使用 std::atomic 进行原子操作，用于多线程测试中的错误标记
+#include <map> // 使用 std::map 测试分配器适配器
+#include <list> // 使用 std::list 测试分配器适配器
+#include <stdexcept> // 使用 std::runtime_error 测试构造失败
+#include <mutex> // 生产者/消费者测试中的队列锁
+#include <condition_variable> // 生产者/消费者测试中的队列通知
+#include <deque> // 生产者/消费者测试中的消息队列
+#include <unistd.h> // 轨迹测试中的临时文件
+#include <chrono> // 衰减测试中的等待
+#include <sys/wait.h> // 共享内存池测试中等待子进程
 
 using namespace memoryPool; // 假设 MemoryPool 类位于 memoryPool 命名空间中，方便直接使用 MemoryPool 而无需加上命名空间前缀
 
@@ -178,6 +195,1420 @@ void testStress()
     std::cout << "Stress test passed!" << std::endl;
 }
 
+void testPoolAllocator()
+{
+    std::cout << "Running pool allocator test..." << std::endl;
+
+    // 标准容器 + PoolAllocator
+    std::vector<int, PoolAllocator<int>> vec;
+    for (int i = 0; i < 10000; ++i)
+    {
+        vec.push_back(i);
+    }
+    for (int i = 0; i < 10000; ++i)
+    {
+        assert(vec[i] == i);
+    }
+
+    std::map<int, int, std::less<int>, PoolAllocator<std::pair<const int, int>>> map;
+    std::list<int, PoolAllocator<int>> list;
+    for (int i = 0; i < 1000; ++i)
+    {
+        map[i] = i * 2;
+        list.push_back(i);
+    }
+    for (int i = 0; i < 1000; i += 2)
+    {
+        map.erase(i);
+    }
+    assert(map.size() == 500 && map[999] == 1998);
+    assert(list.size() == 1000 && list.back() == 999);
+
+    // 过对齐类型
+    struct alignas(64) Aligned
+    {
+        char data[64];
+    };
+    PoolAllocator<Aligned> alignedAlloc;
+    Aligned* aligned = alignedAlloc.allocate(3);
+    assert((reinterpret_cast<uintptr_t>(aligned) & 63) == 0);
+    alignedAlloc.deallocate(aligned, 3);
+
+    // std::pmr 容器
+    std::pmr::vector<std::pmr::string> strings(PoolMemoryResource::getInstance());
+    for (int i = 0; i < 1000; ++i)
+    {
+        strings.emplace_back(std::string(i % 100 + 1, 'x'));
+    }
+    assert(strings[999].size() == 100);
+    assert(*PoolMemoryResource::getInstance() == *PoolMemoryResource::getInstance());
+
+    std::cout << "Pool allocator test passed!" << std::endl;
+}
+
+void testObjectPool()
+{
+    std::cout << "Running object pool test..." << std::endl;
+
+    struct Node
+    {
+        int value;
+        Node* next;
+        Node(int v, Node* n) : value(v), next(n) {}
+    };
+
+    // 构造一条链表后逐个销毁
+    Node* head = nullptr;
+    for (int i = 0; i < 1000; ++i)
+    {
+        head = ObjectPool<Node>::create(i, head);
+    }
+    for (int i = 999; i >= 0; --i)
+    {
+        assert(head->value == i);
+        Node* next = head->next;
+        ObjectPool<Node>::destroy(head);
+        head = next;
+    }
+
+    // 编译期大小与运行期大小落在同一大小类别，可以交叉释放
+    void* ptr = MemoryPool::allocate<24>();
+    assert(ptr != nullptr);
+    MemoryPool::deallocate(ptr, 24);
+    ptr = MemoryPool::allocate(24);
+    MemoryPool::deallocate<24>(ptr);
+
+    // 构造函数抛出异常时内存应被回收
+    struct Throwing
+    {
+        Throwing() { throw std::runtime_error("ctor"); }
+    };
+    [[maybe_unused]] bool caught = false;
+    try
+    {
+        MemoryPool::create<Throwing>();
+    }
+    catch (const std::runtime_error&)
+    {
+        caught = true;
+    }
+    assert(caught);
+
+    // 过对齐类型
+    struct alignas(128) Wide
+    {
+        char data[128];
+    };
+    Wide* wide = MemoryPool::create<Wide>();
+    assert((reinterpret_cast<uintptr_t>(wide) & 127) == 0);
+    MemoryPool::destroy(wide);
+
+    std::cout << "Object pool test passed!" << std::endl;
+}
+
+void testBatchAllocation()
+{
+    std::cout << "Running batch allocation test..." << std::endl;
+
+    // 覆盖小批量（走本地链表）和大批量（直接走中心缓存）两种路径
+    for (size_t count : {size_t(10), size_t(5000)})
+    {
+        for (size_t size : {size_t(16), size_t(200), size_t(4096), MAX_BYTES + 1})
+        {
+            std::vector<void*> ptrs(count);
+            [[maybe_unused]] size_t n = MemoryPool::allocateBatch(size, count, ptrs.data());
+            assert(n == count);
+
+            // 每个内存块都可写且互不重叠
+            for (size_t i = 0; i < count; ++i)
+            {
+                memset(ptrs[i], static_cast<int>(i & 0xff), size);
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                assert(static_cast<unsigned char*>(ptrs[i])[size - 1] == (i & 0xff));
+            }
+
+            MemoryPool::deallocateBatch(size, count, ptrs.data());
+        }
+    }
+
+    // 批量分配的内存可以逐个释放，反之亦然
+    void* ptrs[100];
+    size_t allocated = MemoryPool::allocateBatch(64, 100, ptrs);
+    assert(allocated == 100);
+    for (size_t i = 0; i < allocated; ++i)
+    {
+        MemoryPool::deallocate(ptrs[i], 64);
+    }
+    for (void*& ptr : ptrs)
+    {
+        ptr = MemoryPool::allocate(64);
+    }
+    MemoryPool::deallocateBatch(64, 100, ptrs);
+
+    std::cout << "Batch allocation test passed!" << std::endl;
+}
+
+void testCrossThreadFree()
+{
+    std::cout << "Running cross-thread free test..." << std::endl;
+
+    // 生产者分配消息，消费者释放：消费者释放的内存块应通过远程释放链表回到生产者
+    const size_t NUM_MESSAGES = 200000;
+    const size_t MESSAGE_SIZE = 96;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::pair<void*, size_t>> queue;
+    bool done = false;
+    std::atomic<bool> corrupted{false};
+
+    std::thread producer([&]()
+    {
+        for (size_t i = 0; i < NUM_MESSAGES; ++i)
+        {
+            void* msg = MemoryPool::allocate(MESSAGE_SIZE);
+            assert(msg != nullptr);
+            memset(msg, static_cast<int>(i & 0xff), MESSAGE_SIZE);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.emplace_back(msg, i);
+            }
+            cv.notify_one();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        cv.notify_one();
+    });
+
+    std::thread consumer([&]()
+    {
+        for (;;)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&]() { return !queue.empty() || done; });
+            if (queue.empty()) break;
+
+            auto [msg, seq] = queue.front();
+            queue.pop_front();
+            lock.unlock();
+
+            // 消息内容在释放前不应被其他分配覆盖
+            const unsigned char* bytes = static_cast<const unsigned char*>(msg);
+            if (bytes[0] != (seq & 0xff) || bytes[MESSAGE_SIZE - 1] != (seq & 0xff))
+            {
+                corrupted = true;
+            }
+            MemoryPool::deallocate(msg, MESSAGE_SIZE);
+        }
+    });
+
+    producer.join();
+    consumer.join();
+    assert(!corrupted);
+
+    std::cout << "Cross-thread free test passed!" << std::endl;
+}
+
+void testRemoteFreeOwner()
+{
+    std::cout << "Running remote free owner test..." << std::endl;
+
+    // 大于 1024 字节的类别每次只从中心缓存取 1 个，所属线程的本地链表保持为空
+    const size_t SIZE = 1336;
+    const size_t COUNT = 2000;
+    const size_t FIRST = 100;
+
+    std::vector<void*> owned(COUNT);
+    std::atomic<int> phase{0};
+    void* reused = nullptr;
+
+    // 所属线程分配全部内存块后保持空闲，只在本线程第一次释放后再分配一次
+    std::thread owner([&]
+    {
+        for (void*& ptr : owned) ptr = MemoryPool::allocate(SIZE);
+        phase = 1;
+        while (phase != 2) std::this_thread::yield();
+        reused = MemoryPool::allocate(SIZE);
+        phase = 3;
+        while (phase != 4) std::this_thread::yield();
+        MemoryPool::deallocate(reused, SIZE);
+    });
+    while (phase != 1) std::this_thread::yield();
+
+    // 本线程释放的内存块超过本地容量后送回所属线程，所属线程下次未命中时取回
+    for (size_t i = 0; i < FIRST; ++i) MemoryPool::deallocate(owned[i], SIZE);
+    phase = 2;
+    while (phase != 3) std::this_thread::yield();
+    [[maybe_unused]] bool returnedToOwner = std::find(owned.begin(), owned.begin() + FIRST, reused) != owned.begin() + FIRST;
+    assert(returnedToOwner);
+
+    // 所属线程空闲时，远程释放链表积压到上限后由释放线程取回并归还给中心缓存，
+    // 变空的 slab 随之回到页缓存，而不是一直滞留在所属线程的远程释放链表中
+    [[maybe_unused]] size_t pageCacheBefore = MemoryPool::getStats().pageCacheFreeBytes;
+    for (size_t i = FIRST; i < COUNT; ++i) MemoryPool::deallocate(owned[i], SIZE);
+    [[maybe_unused]] size_t pageCacheAfter = MemoryPool::getStats().pageCacheFreeBytes;
+    assert(pageCacheAfter >= pageCacheBefore + (COUNT - FIRST) / 2 * SIZE);
+
+    phase = 4;
+    owner.join();
+
+    std::cout << "Remote free owner test passed!" << std::endl;
+}
+
+// 在统计结果中查找指定大小的类别
+static ClassStats findClass(const PoolStats& stats, size_t size)
+{
+    for (const ClassStats& cls : stats.classes)
+    {
+        if (cls.size == size) return cls;
+    }
+    return ClassStats{};
+}
+
+void testStats()
+{
+    std::cout << "Running stats test..." << std::endl;
+
+    // 请求 100 字节，落在 104 字节的大小类别，每个内存块浪费 4 字节
+    const size_t NUM_ALLOCS = 1000;
+    PoolStats before = MemoryPool::getStats();
+    [[maybe_unused]] ClassStats beforeClass = findClass(before, 104);
+
+    std::vector<void*> ptrs;
+    for (size_t i = 0; i < NUM_ALLOCS; ++i)
+    {
+        ptrs.push_back(MemoryPool::allocate(100));
+    }
+
+    PoolStats during = MemoryPool::getStats();
+    [[maybe_unused]] ClassStats duringClass = findClass(during, 104);
+    assert(duringClass.allocs - beforeClass.allocs == NUM_ALLOCS);
+    assert(duringClass.frees == beforeClass.frees);
+    assert(duringClass.internalFragmentation >= beforeClass.internalFragmentation + 4 * NUM_ALLOCS / 2);
+    assert(during.liveBytes >= before.liveBytes + 104 * NUM_ALLOCS);
+    assert(during.mappedBytes >= during.pageCacheFreeBytes + during.centralCacheBytes);
+    assert(during.residentBytes == during.mappedBytes - during.releasedBytes);
+    assert(during.threadCaches >= 1);
+
+    for (void* ptr : ptrs)
+    {
+        MemoryPool::deallocate(ptr, 100);
+    }
+
+    PoolStats after = MemoryPool::getStats();
+    [[maybe_unused]] ClassStats afterClass = findClass(after, 104);
+    assert(afterClass.frees - beforeClass.frees == NUM_ALLOCS);
+    assert(afterClass.allocs - afterClass.frees == beforeClass.allocs - beforeClass.frees);
+    assert(after.liveBytes == before.liveBytes);
+
+    // 大对象计数
+    void* large = MemoryPool::allocate(MAX_BYTES + 1);
+    MemoryPool::deallocate(large, MAX_BYTES + 1);
+    PoolStats largeStats = MemoryPool::getStats();
+    assert(largeStats.largeAllocs == after.largeAllocs + 1);
+    assert(largeStats.largeFrees == after.largeFrees + 1);
+
+    // 可读输出
+    FILE* out = tmpfile();
+    assert(out != nullptr);
+    MemoryPool::dumpStats(out);
+    assert(ftell(out) > 0);
+    fclose(out);
+
+    std::cout << "Stats test passed!" << std::endl;
+}
+
+void testThreadCacheDecay()
+{
+    std::cout << "Running thread cache decay test..." << std::endl;
+
+    // 在新线程中运行，线程缓存的内容只来自本测试
+    std::thread worker([]
+    {
+        const size_t SIZE = 2000;
+        const size_t NUM_BLOCKS = 40; // 不超过本地容量，释放后全部留在线程缓存中
+        MemoryPool::setThreadCacheDecay(20);
+
+        PoolStats initial = MemoryPool::getStats();
+        [[maybe_unused]] size_t baseline = findClass(initial, SIZE).threadCacheBytes;
+        [[maybe_unused]] size_t probeBaseline = findClass(initial, 2504).threadCacheBytes;
+
+        std::vector<void*> ptrs;
+        for (size_t i = 0; i < NUM_BLOCKS; ++i) ptrs.push_back(MemoryPool::allocate(SIZE));
+        for (void* ptr : ptrs) MemoryPool::deallocate(ptr, SIZE);
+        assert(findClass(MemoryPool::getStats(), SIZE).threadCacheBytes == baseline + NUM_BLOCKS * SIZE);
+
+        // 用未使用过的大小类别触发慢速路径：第一次衰减记下低水位，第二次归还整个间隔内未被用到的部分
+        std::vector<std::pair<void*, size_t>> probes;
+        for (size_t probeSize : {2504, 2512})
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(30));
+            probes.push_back({MemoryPool::allocate(probeSize), probeSize});
+        }
+        assert(findClass(MemoryPool::getStats(), SIZE).threadCacheBytes == baseline);
+
+        // 手动归还
+        MemoryPool::setThreadCacheDecay(0);
+        ptrs.clear();
+        for (size_t i = 0; i < NUM_BLOCKS; ++i) ptrs.push_back(MemoryPool::allocate(SIZE));
+        for (void* ptr : ptrs) MemoryPool::deallocate(ptr, SIZE);
+        for (auto& probe : probes) MemoryPool::deallocate(probe.first, probe.second);
+        MemoryPool::releaseThreadCache();
+        PoolStats stats = MemoryPool::getStats();
+        assert(findClass(stats, SIZE).threadCacheBytes == baseline);
+        assert(findClass(stats, 2504).threadCacheBytes == probeBaseline);
+
+        MemoryPool::setThreadCacheDecay(1000);
+    });
+    worker.join();
+
+    std::cout << "Thread cache decay test passed!" << std::endl;
+}
+
+void testAsyncRefill()
+{
+    std::cout << "Running async refill test..." << std::endl;
+
+    std::thread worker([]
+    {
+        const size_t SIZE = 48;
+        const size_t NUM_ALLOCS = 4000;
+        MemoryPool::enableAsyncRefill();
+        [[maybe_unused]] size_t deliveredBefore = AsyncRefill::deliveredBatches();
+
+        std::vector<void*> ptrs;
+        for (size_t i = 0; i < NUM_ALLOCS; ++i)
+        {
+            void* ptr = MemoryPool::allocate(SIZE);
+            assert(ptr != nullptr);
+            memset(ptr, static_cast<int>(i & 0xff), SIZE);
+            ptrs.push_back(ptr);
+
+            // 给后台线程留出运行的机会
+            if (i % 16 == 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        assert(AsyncRefill::deliveredBatches() > deliveredBefore);
+
+        // 后台线程补充的内存块不应与已分配的重叠
+        for (size_t i = 0; i < NUM_ALLOCS; ++i)
+        {
+            [[maybe_unused]] const unsigned char* bytes = static_cast<const unsigned char*>(ptrs[i]);
+            for (size_t j = 0; j < SIZE; ++j) assert(bytes[j] == (i & 0xff));
+        }
+
+        MemoryPool::disableAsyncRefill();
+        for (void* ptr : ptrs) MemoryPool::deallocate(ptr, SIZE);
+
+        // 关闭后再开启，信箱被复用
+        MemoryPool::enableAsyncRefill();
+        void* ptr = MemoryPool::allocate(SIZE);
+        MemoryPool::deallocate(ptr, SIZE);
+    });
+    worker.join();
+
+    std::cout << "Async refill test passed!" << std::endl;
+}
+
+void testHeap()
+{
+    std::cout << "Running independent heap test..." << std::endl;
+
+    [[maybe_unused]] size_t globalMapped = MemoryPool::getStats().mappedBytes;
+    {
+        Heap heap;
+        std::vector<void*> ptrs;
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            void* ptr = heap.allocate(64);
+            assert(ptr != nullptr);
+            memset(ptr, 0x3c, 64);
+            ptrs.push_back(ptr);
+        }
+        void* large = heap.allocate(MAX_BYTES + 1);
+        assert(large != nullptr);
+        memset(large, 0x3c, MAX_BYTES + 1);
+
+        // 其他线程在同一个堆上分配，并释放本线程的一部分对象
+        std::thread worker([&]
+        {
+            for (size_t i = 0; i < 500; ++i) heap.deallocate(ptrs[i], 64);
+            void* ptr = heap.allocate(128);
+            heap.deallocate(ptr, 128);
+        });
+        worker.join();
+
+        PoolStats stats = heap.getStats();
+        assert(stats.mappedBytes >= 1000 * 64 + MAX_BYTES + 1);
+        assert(stats.liveBytes == 500 * 64);
+        assert(stats.largeAllocs == 1);
+        assert(stats.threadCaches == 2);
+        // 堆的内存不经过全局内存池
+        assert(MemoryPool::getStats().mappedBytes == globalMapped);
+
+        // 整体释放后堆为空，可以继续使用
+        heap.destroy();
+        stats = heap.getStats();
+        assert(stats.mappedBytes == 0);
+        assert(stats.liveBytes == 0);
+        assert(stats.threadCacheBytes == 0 && stats.centralCacheBytes == 0);
+
+        void* ptr = heap.allocate(64);
+        memset(ptr, 0x5a, 64);
+        heap.deallocate(ptr, 64);
+    }
+    assert(MemoryPool::getStats().mappedBytes == globalMapped);
+
+    std::cout << "Independent heap test passed!" << std::endl;
+}
+
+void testArena()
+{
+    std::cout << "Running arena test..." << std::endl;
+
+    Arena arena;
+    assert(arena.bytesUsed() == 0);
+
+    // 顺序分配，满足对齐
+    char* first = static_cast<char*>(arena.allocate(10));
+    char* second = static_cast<char*>(arena.allocate(10));
+    assert(first != nullptr && second != nullptr && second >= first + 10);
+    [[maybe_unused]] void* aligned = arena.allocate(24, 64);
+    assert(reinterpret_cast<uintptr_t>(aligned) % 64 == 0);
+    memset(first, 1, 10);
+    memset(second, 2, 10);
+
+    struct Point { int x; int y; };
+    [[maybe_unused]] Point* point = arena.create<Point>(Point{3, 4});
+    assert(point->x == 3 && point->y == 4);
+
+    // 回滚：之间分配的对象作废，包括跨越多段 span 的分配
+    Arena::Savepoint savepoint = arena.save();
+    [[maybe_unused]] size_t usedAtSavepoint = arena.bytesUsed();
+    [[maybe_unused]] void* afterSave = arena.allocate(100);
+    for (int i = 0; i < 100; ++i) memset(arena.allocate(4096), 0x7f, 4096);
+    void* large = arena.allocate(1024 * 1024);
+    memset(large, 0x7f, 1024 * 1024);
+    assert(arena.bytesReserved() >= 100 * 4096 + 1024 * 1024);
+    arena.rollback(savepoint);
+    assert(arena.bytesUsed() == usedAtSavepoint);
+    [[maybe_unused]] void* reused = arena.allocate(100);
+    assert(reused == afterSave);
+    assert(first[0] == 1 && second[9] == 2);
+
+    // reset 保留一段 span，之后从同一位置重新开始
+    arena.reset();
+    assert(arena.bytesUsed() == 0);
+    assert(arena.bytesReserved() == Arena::DEFAULT_SPAN_PAGES * PageCache::PAGE_SIZE);
+    [[maybe_unused]] void* restarted = arena.allocate(10);
+    assert(restarted == first);
+
+    std::cout << "Arena test passed!" << std::endl;
+}
+
+void testRealtime()
+{
+    std::cout << "Running realtime mode test..." << std::endl;
+
+    const size_t HEAP_BYTES = 4 * 1024 * 1024;
+    RealtimeConfig config;
+    config.heapBytes = HEAP_BYTES;
+    config.classes = {{48, 200}, {1024, 64}};
+
+    [[maybe_unused]] auto classStats = [](const PoolStats& stats, size_t size)
+    {
+        for (const ClassStats& cls : stats.classes)
+        {
+            if (cls.size == size) return cls;
+        }
+        return ClassStats{};
+    };
+
+    // 在新线程中进行，线程缓存从空开始
+    std::thread worker([&]
+    {
+        MemoryPool::releaseThreadCache();
+        PoolStats before = MemoryPool::getStats();
+        [[maybe_unused]] uint64_t decay = ThreadCache::decayInterval();
+
+        [[maybe_unused]] bool entered = MemoryPool::enterRealtime(config);
+        assert(entered);
+        PoolStats stats = MemoryPool::getStats();
+        assert(stats.mappedBytes == before.mappedBytes + HEAP_BYTES);
+        assert(ThreadCache::decayInterval() == 0);
+
+        // 线程缓存最多预先填充 64 个，其余留在中心缓存
+        assert(classStats(stats, 48).threadCacheBytes - classStats(before, 48).threadCacheBytes == 64 * 48);
+        assert(classStats(stats, 1024).threadCacheBytes - classStats(before, 1024).threadCacheBytes == 64 * 1024);
+        assert(classStats(stats, 48).centralFreeBytes >= (200 - 64) * 48);
+
+        // 堆用尽时分配失败而不是增长
+        const size_t LARGE = MAX_BYTES * 2;
+        std::vector<void*> large;
+        while (void* ptr = MemoryPool::allocate(LARGE))
+        {
+            memset(ptr, 0x6e, LARGE);
+            large.push_back(ptr);
+        }
+        assert(!large.empty());
+        assert(MemoryPool::getStats().mappedBytes == stats.mappedBytes);
+
+        // 大对象来自页缓存，带大小和不带大小的释放都归还给页缓存
+        assert(PageCache::getObjectSize(large[0]) >= LARGE);
+        MemoryPool::deallocate(large[0]);
+        for (size_t i = 1; i < large.size(); ++i) MemoryPool::deallocate(large[i], LARGE);
+        void* again = MemoryPool::allocate(LARGE);
+        assert(again != nullptr);
+
+        // 退出后恢复增长，新的大对象重新来自 malloc，实时模式下分配的大对象仍可释放
+        MemoryPool::exitRealtime();
+        assert(ThreadCache::decayInterval() == decay);
+        void* ptr = MemoryPool::allocate(LARGE);
+        assert(ptr != nullptr && PageCache::getObjectSize(ptr) == 0);
+        MemoryPool::deallocate(ptr, LARGE);
+        MemoryPool::deallocate(again, LARGE);
+    });
+    worker.join();
+
+    std::cout << "Realtime mode test passed!" << std::endl;
+}
+
+void testPrewarm()
+{
+    std::cout << "Running prewarm test..." << std::endl;
+
+    auto classStats = [](size_t size)
+    {
+        for (const ClassStats& cls : MemoryPool::getStats().classes)
+        {
+            if (cls.size == size) return cls;
+        }
+        return ClassStats{};
+    };
+
+    // 预留后，首批分配全部由线程缓存满足，不再从中心缓存获取
+    const size_t SIZE = 3000;
+    std::thread worker([&]
+    {
+        [[maybe_unused]] ClassStats before = classStats(SIZE);
+        [[maybe_unused]] bool ok = MemoryPool::reserve(SIZE, 100);
+        assert(ok);
+        [[maybe_unused]] ClassStats reserved = classStats(SIZE);
+        assert(reserved.threadCacheBytes - before.threadCacheBytes == PrewarmProfile::MAX_THREAD_BLOCKS * SIZE);
+        assert(reserved.centralFreeBytes >= (100 - PrewarmProfile::MAX_THREAD_BLOCKS) * SIZE);
+
+        std::vector<void*> ptrs;
+        for (size_t i = 0; i < PrewarmProfile::MAX_THREAD_BLOCKS; ++i)
+        {
+            void* ptr = MemoryPool::allocate(SIZE);
+            memset(ptr, 0x42, SIZE);
+            ptrs.push_back(ptr);
+        }
+        [[maybe_unused]] ClassStats used = classStats(SIZE);
+        assert(used.threadCacheBytes == before.threadCacheBytes);
+        assert(used.centralFreeBytes == reserved.centralFreeBytes);
+        for (void* ptr : ptrs) MemoryPool::deallocate(ptr, SIZE);
+    });
+    worker.join();
+
+    // 由统计生成配置，保存后读回
+    PoolStats stats;
+    stats.classes = {{64, 1000, 0}, {128, 10, 0}, {256, 0, 0}, {512, 500, 0}};
+    PrewarmProfile profile = PrewarmProfile::fromStats(stats, 2);
+    assert(profile.classes.size() == 2);
+    assert(profile.classes[0].size == 64 && profile.classes[0].count == PrewarmProfile::MAX_THREAD_BLOCKS);
+    assert(profile.classes[1].size == 512 && profile.classes[1].count == PrewarmProfile::MAX_THREAD_BLOCKS / 2);
+
+    FILE* file = tmpfile();
+    assert(file != nullptr);
+    [[maybe_unused]] bool saved = profile.save(file);
+    assert(saved);
+    rewind(file);
+    PrewarmProfile loaded = PrewarmProfile::load(file);
+    fclose(file);
+    assert(loaded.classes.size() == 2);
+    assert(loaded.classes[1].size == 512 && loaded.classes[1].count == PrewarmProfile::MAX_THREAD_BLOCKS / 2);
+
+    std::thread prewarmed([&]
+    {
+        [[maybe_unused]] bool ok = MemoryPool::prewarm(loaded);
+        assert(ok);
+        void* ptr = MemoryPool::allocate(512);
+        memset(ptr, 0x24, 512);
+        MemoryPool::deallocate(ptr, 512);
+    });
+    prewarmed.join();
+
+    std::cout << "Prewarm test passed!" << std::endl;
+}
+
+void testPersistentHeap()
+{
+    std::cout << "Running persistent heap test..." << std::endl;
+
+    char path[] = "/tmp/memory_pool_heapXXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+
+    // 堆中的链表，重启后通过根对象找回
+    struct Node
+    {
+        Node* next;
+        size_t value;
+        char payload[40];
+    };
+
+    const size_t HEAP_SIZE = 16 * 1024 * 1024;
+    const size_t NODES = 10000;
+    const size_t LARGE = MAX_BYTES * 2;
+    [[maybe_unused]] size_t allocated = 0;
+    void* largeBlock = nullptr;
+    {
+        auto heap = MemoryPool::openPersistent(path, HEAP_SIZE);
+        assert(heap && heap->wasCleanShutdown());
+        assert(heap->capacity() == HEAP_SIZE);
+        assert(heap->root() == nullptr);
+
+        // 同一个堆不能同时打开两次
+        auto second = MemoryPool::openPersistent(path);
+        assert(second == nullptr);
+
+        Node* head = nullptr;
+        for (size_t i = 0; i < NODES; ++i)
+        {
+            Node* node = static_cast<Node*>(heap->allocate(sizeof(Node)));
+            assert(node != nullptr);
+            node->next = head;
+            node->value = i;
+            head = node;
+        }
+        heap->setRoot(head);
+
+        // 大对象按页分配，释放后页段被再次使用
+        largeBlock = heap->allocate(LARGE);
+        assert(largeBlock != nullptr);
+        heap->deallocate(largeBlock, LARGE);
+        void* again = heap->allocate(LARGE);
+        assert(again == largeBlock);
+        memset(again, 0x5c, LARGE);
+
+        allocated = heap->bytesAllocated();
+        assert(allocated >= NODES * sizeof(Node) + LARGE);
+        [[maybe_unused]] bool synced = heap->sync();
+        assert(synced);
+    }
+
+    // 重新打开：映射到相同的地址，链表和元数据都在
+    {
+        auto heap = MemoryPool::openPersistent(path);
+        assert(heap && heap->wasCleanShutdown());
+        assert(heap->capacity() == HEAP_SIZE);
+        assert(heap->bytesAllocated() == allocated);
+
+        size_t count = 0;
+        for (Node* node = static_cast<Node*>(heap->root()); node; node = node->next)
+        {
+            assert(node->value == NODES - 1 - count);
+            ++count;
+        }
+        assert(count == NODES);
+        assert(static_cast<unsigned char*>(largeBlock)[LARGE - 1] == 0x5c);
+
+        // 释放的内存块回到自由链表，下一次分配取回同一个
+        Node* head = static_cast<Node*>(heap->root());
+        heap->setRoot(head->next);
+        heap->deallocate(head, sizeof(Node));
+        void* reused = heap->allocate(sizeof(Node));
+        assert(reused == head);
+        heap->deallocate(reused, sizeof(Node));
+        heap->deallocate(largeBlock, LARGE);
+
+        // 堆用尽时返回 nullptr
+        std::vector<void*> blocks;
+        while (void* block = heap->allocate(LARGE)) blocks.push_back(block);
+        assert(!blocks.empty());
+        for (void* block : blocks) heap->deallocate(block, LARGE);
+        void* first = heap->allocate(LARGE);
+        assert(first == largeBlock);
+        heap->deallocate(first, LARGE);
+    }
+    unlink(path);
+
+    // memfd：关闭堆后通过仍然打开的描述符重新映射
+    {
+        auto heap = PersistentHeap::createMemfd("memory_pool_test", HEAP_SIZE);
+        assert(heap != nullptr);
+        int memfd = dup(heap->fd());
+        void* block = heap->allocate(128);
+        memset(block, 0x3e, 128);
+        heap->setRoot(block);
+        heap.reset();
+
+        heap = PersistentHeap::open(memfd, 0);
+        assert(heap && heap->root() == block);
+        assert(static_cast<unsigned char*>(block)[127] == 0x3e);
+        heap.reset();
+        close(memfd);
+    }
+
+    std::cout << "Persistent heap test passed!" << std::endl;
+}
+
+void testSharedPool()
+{
+    std::cout << "Running shared pool test..." << std::endl;
+
+    char name[64];
+    snprintf(name, sizeof(name), "/memory_pool_test_%d", static_cast<int>(getpid()));
+    SharedPool::unlink(name);
+
+    const size_t POOL_SIZE = 64 * 1024 * 1024;
+    const size_t MESSAGES = 2000;
+    const size_t LARGE = MAX_BYTES * 2;
+
+    auto pool = MemoryPool::createShared(name, POOL_SIZE);
+    assert(pool && pool->capacity() == POOL_SIZE);
+    auto duplicate = MemoryPool::createShared(name, POOL_SIZE);
+    assert(duplicate == nullptr);
+
+    // 同一进程内的分配与释放
+    void* small = pool->allocate(24);
+    assert(small != nullptr);
+    pool->deallocate(small, 24);
+    void* reused = pool->allocate(24);
+    assert(reused == small);
+    pool->deallocate(reused, 24);
+
+    // 生产者在本进程分配消息并写入内容，把偏移通过管道交给另一个进程，由对方读取并释放
+    auto exchange = [&]
+    {
+        int fds[2];
+        [[maybe_unused]] int piped = pipe(fds);
+        assert(piped == 0);
+        pid_t pid = fork();
+        assert(pid >= 0);
+        if (pid == 0)
+        {
+            close(fds[1]);
+            auto consumer = MemoryPool::attachShared(name);
+            bool ok = consumer != nullptr;
+            uint64_t offset;
+            size_t received = 0;
+            while (ok && read(fds[0], &offset, sizeof(offset)) == sizeof(offset))
+            {
+                size_t size = received % 64 == 63 ? LARGE : 16 + received % 200;
+                unsigned char* message = consumer->fromOffset<unsigned char>(offset);
+                ok = message[0] == static_cast<unsigned char>(received) &&
+                     message[size - 1] == static_cast<unsigned char>(received);
+                consumer->deallocate(message, size);
+                ++received;
+            }
+            consumer.reset();
+            _exit(ok && received == MESSAGES ? 0 : 1);
+        }
+
+        close(fds[0]);
+        for (size_t i = 0; i < MESSAGES; ++i)
+        {
+            size_t size = i % 64 == 63 ? LARGE : 16 + i % 200;
+            unsigned char* message = static_cast<unsigned char*>(pool->allocate(size));
+            assert(message != nullptr);
+            message[0] = message[size - 1] = static_cast<unsigned char>(i);
+            uint64_t offset = pool->toOffset(message);
+            [[maybe_unused]] ssize_t written = write(fds[1], &offset, sizeof(offset));
+            assert(written == sizeof(offset));
+        }
+        close(fds[1]);
+
+        int status = 0;
+        [[maybe_unused]] pid_t waited = waitpid(pid, &status, 0);
+        assert(waited == pid);
+        assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    };
+
+    exchange();
+    [[maybe_unused]] size_t carved = pool->bytesCarved();
+    assert(carved > 0);
+
+    // 对方释放的内存块回到共享的中心层和页层，第二轮不再切分新的内存
+    exchange();
+    assert(pool->bytesCarved() == carved);
+
+    // 多个线程并发分配释放，线程退出时线程缓存归还中心层
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&pool]
+        {
+            std::vector<void*> blocks;
+            for (size_t i = 0; i < 1000; ++i) blocks.push_back(pool->allocate(64));
+            for (void* block : blocks)
+            {
+                assert(block != nullptr);
+                pool->deallocate(block, 64);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    pool->releaseThreadCache();
+
+    // 段用尽时返回 nullptr
+    std::vector<void*> blocks;
+    while (void* block = pool->allocate(LARGE)) blocks.push_back(block);
+    assert(!blocks.empty());
+    for (void* block : blocks) pool->deallocate(block, LARGE);
+
+    pool.reset();
+    [[maybe_unused]] bool unlinked = SharedPool::unlink(name);
+    assert(unlinked);
+    auto removed = MemoryPool::attachShared(name);
+    assert(removed == nullptr);
+
+    std::cout << "Shared pool test passed!" << std::endl;
+}
+
+// 记录压力回调的调用次数
+struct PressureCounts
+{
+    std::atomic<int> soft{0};
+    std::atomic<int> hard{0};
+};
+
+void countPressure(MemoryPressure level, size_t, void* arg)
+{
+    PressureCounts* counts = static_cast<PressureCounts*>(arg);
+    if (level == MemoryPressure::HARD) counts->hard++;
+    else counts->soft++;
+}
+
+void testMemoryLimit()
+{
+    std::cout << "Running memory limit test..." << std::endl;
+
+    const size_t MB = 1024 * 1024;
+    const size_t BLOCK = 4096;
+    PressureCounts counts;
+
+    MemoryPool::releaseFreeMemory();
+    size_t base = MemoryPool::getStats().residentBytes;
+    MemoryPool::setMemoryLimits(base + 2 * MB, base + 8 * MB);
+    MemoryPool::setPressureCallback(&countPressure, &counts);
+
+    // 超过软限制后继续增长，直到触及硬限制时分配失败
+    std::vector<void*> blocks;
+    while (blocks.size() < 100000)
+    {
+        void* ptr = MemoryPool::allocate(BLOCK);
+        if (!ptr) break;
+        memset(ptr, 0x6d, BLOCK);
+        blocks.push_back(ptr);
+    }
+    assert(blocks.size() < 100000);
+    assert(blocks.size() * BLOCK > 4 * MB);
+    assert(counts.soft > 0 && counts.hard > 0);
+    assert(MemoryPool::getStats().residentBytes <= base + 8 * MB);
+
+    // 释放后归还操作系统：驻留字节数回到起点附近，之后仍可在限制内复用
+    for (void* ptr : blocks) MemoryPool::deallocate(ptr, BLOCK);
+    blocks.clear();
+    [[maybe_unused]] size_t released = MemoryPool::releaseFreeMemory();
+    PoolStats stats = MemoryPool::getStats();
+    assert(released >= 4 * MB);
+    assert(stats.releasedBytes >= released);
+    assert(stats.residentBytes < base + MB);
+
+    for (size_t i = 0; i < 256; ++i)
+    {
+        void* ptr = MemoryPool::allocate(BLOCK);
+        assert(ptr != nullptr);
+        memset(ptr, 0x2a, BLOCK);
+        blocks.push_back(ptr);
+    }
+    for (void* ptr : blocks) MemoryPool::deallocate(ptr, BLOCK);
+
+    MemoryPool::setMemoryLimits(0, 0);
+
+    // 压力监视器：用临时文件模拟 PSI 和 cgroup 文件
+    char dir[] = "/tmp/memory_pool_psiXXXXXX";
+    [[maybe_unused]] char* created = mkdtemp(dir);
+    assert(created != nullptr);
+    std::string pressurePath = std::string(dir) + "/memory.pressure";
+    std::string maxPath = std::string(dir) + "/memory.max";
+    std::string currentPath = std::string(dir) + "/memory.current";
+    auto writeFile = [](const std::string& path, const char* content)
+    {
+        FILE* file = fopen(path.c_str(), "w");
+        assert(file != nullptr);
+        fputs(content, file);
+        fclose(file);
+    };
+
+    PressureWatcherConfig config;
+    config.pressurePath = pressurePath;
+    config.maxPath = maxPath;
+    config.currentPath = currentPath;
+    config.intervalMs = 10;
+
+    writeFile(pressurePath, "some avg10=0.00 avg60=0.00 avg300=0.00 total=0\n"
+                            "full avg10=0.00 avg60=0.00 avg300=0.00 total=0\n");
+    writeFile(maxPath, "max\n");
+    writeFile(currentPath, "123456789\n");
+    assert(MemoryLimit::evaluate(config) == MemoryPressure::NONE);
+
+    writeFile(pressurePath, "some avg10=25.50 avg60=3.00 avg300=1.00 total=1000\n"
+                            "full avg10=1.00 avg60=0.00 avg300=0.00 total=10\n");
+    assert(MemoryLimit::evaluate(config) == MemoryPressure::SOFT);
+    writeFile(pressurePath, "some avg10=40.00 avg60=3.00 avg300=1.00 total=1000\n"
+                            "full avg10=12.00 avg60=0.00 avg300=0.00 total=10\n");
+    assert(MemoryLimit::evaluate(config) == MemoryPressure::HARD);
+
+    writeFile(pressurePath, "some avg10=0.00 avg60=0.00 avg300=0.00 total=0\n");
+    writeFile(maxPath, "1000000\n");
+    writeFile(currentPath, "850000\n");
+    assert(MemoryLimit::evaluate(config) == MemoryPressure::SOFT);
+    writeFile(currentPath, "990000\n");
+    assert(MemoryLimit::evaluate(config) == MemoryPressure::HARD);
+
+    // 后台线程检测到压力后调用回调
+    int before = counts.hard;
+    MemoryPool::startPressureWatcher(config);
+    for (int i = 0; i < 200 && counts.hard == before; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    MemoryPool::stopPressureWatcher();
+    assert(counts.hard > before);
+
+    MemoryPool::setPressureCallback(nullptr);
+    unlink(pressurePath.c_str());
+    unlink(maxPath.c_str());
+    unlink(currentPath.c_str());
+    rmdir(dir);
+
+    std::cout << "Memory limit test passed!" << std::endl;
+}
+
+// 模拟的两节点拓扑：线程所在节点由测试设定，记录每次绑定的地址范围
+class FakeTopology : public NumaTopology
+{
+public:
+    static inline thread_local size_t node = 0;
+
+    size_t nodeCount() const override { return 2; }
+    size_t currentNode() const override { return node; }
+
+    bool bind(void* addr, size_t bytes, size_t target) const override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ranges_.push_back({static_cast<char*>(addr), bytes, target});
+        return true;
+    }
+
+    // 指针所在范围绑定的节点，未绑定时返回 SIZE_MAX
+    size_t nodeOf(void* ptr) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Range& range : ranges_)
+        {
+            if (ptr >= range.addr && ptr < range.addr + range.bytes) return range.node;
+        }
+        return SIZE_MAX;
+    }
+
+private:
+    struct Range
+    {
+        char* addr;
+        size_t bytes;
+        size_t node;
+    };
+
+    mutable std::mutex mutex_;
+    mutable std::vector<Range> ranges_;
+};
+
+void testNuma()
+{
+    std::cout << "Running NUMA shard test..." << std::endl;
+
+    // 分片的页缓存持有拓扑，须在进程剩余时间内有效
+    static FakeTopology topology;
+    const size_t SIZE = 3016;
+    const size_t COUNT = 200;
+
+    [[maybe_unused]] size_t mappedBefore = MemoryPool::getStats().mappedBytes;
+    [[maybe_unused]] bool enabled = MemoryPool::enableNuma(&topology);
+    assert(enabled);
+
+    // 节点 1 上的线程从节点 1 的分片取内存，新映射的内存绑定到节点 1
+    std::vector<void*> remote(COUNT);
+    std::thread([&]
+    {
+        FakeTopology::node = 1;
+        for (void*& ptr : remote)
+        {
+            ptr = MemoryPool::allocate(SIZE);
+            assert(ptr != nullptr);
+            memset(ptr, 0x11, SIZE);
+        }
+    }).join();
+    for ([[maybe_unused]] void* ptr : remote) assert(topology.nodeOf(ptr) == 1);
+    assert(MemoryPool::getStats().mappedBytes >= mappedBefore + COUNT * SIZE);
+
+    // 节点 0 上的线程不使用节点 1 的内存
+    std::vector<void*> local(COUNT);
+    for (void*& ptr : local)
+    {
+        ptr = MemoryPool::allocate(SIZE);
+        assert(ptr != nullptr && topology.nodeOf(ptr) != 1);
+    }
+
+    // 跨节点释放：节点 0 的线程释放节点 1 的内存块，它们回到节点 1 的分片，之后由节点 1 的线程复用
+    for (void* ptr : remote) MemoryPool::deallocate(ptr, SIZE);
+    for (void* ptr : local) MemoryPool::deallocate(ptr, SIZE);
+    MemoryPool::releaseThreadCache();
+    std::thread([&]
+    {
+        FakeTopology::node = 1;
+        for (size_t i = 0; i < COUNT; ++i)
+        {
+            void* ptr = MemoryPool::allocate(SIZE);
+            assert(topology.nodeOf(ptr) == 1);
+            MemoryPool::deallocate(ptr, SIZE);
+        }
+    }).join();
+
+    // 线程迁移到另一个节点后，下一次慢速路径改从新节点取
+    std::thread([&]
+    {
+        void* first = MemoryPool::allocate(SIZE + 512);
+        assert(topology.nodeOf(first) != 1);
+        FakeTopology::node = 1;
+        void* second = MemoryPool::allocate(SIZE + 1024);
+        assert(topology.nodeOf(second) == 1);
+        MemoryPool::deallocate(first, SIZE + 512);
+        MemoryPool::deallocate(second, SIZE + 1024);
+    }).join();
+
+    // 异步补充同样跟随迁移：在节点 0 上开启，迁移后后台线程从节点 1 的分片取
+    std::thread([&]
+    {
+        const size_t ASYNC_SIZE = SIZE + 1536;
+        MemoryPool::enableAsyncRefill();
+        [[maybe_unused]] size_t deliveredBefore = AsyncRefill::deliveredBatches();
+        FakeTopology::node = 1;
+
+        std::vector<void*> ptrs;
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            void* ptr = MemoryPool::allocate(ASYNC_SIZE);
+            assert(ptr != nullptr && topology.nodeOf(ptr) == 1);
+            ptrs.push_back(ptr);
+            if (i % 16 == 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        assert(AsyncRefill::deliveredBatches() > deliveredBefore);
+
+        MemoryPool::disableAsyncRefill();
+        for (void* ptr : ptrs) MemoryPool::deallocate(ptr, ASYNC_SIZE);
+    }).join();
+
+    // 多个线程在两个节点上交叉分配和释放
+    std::vector<std::thread> threads;
+    std::vector<std::vector<void*>> blocks(4);
+    for (size_t t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&blocks, t]
+        {
+            FakeTopology::node = t % 2;
+            for (size_t i = 0; i < 2000; ++i) blocks[t].push_back(MemoryPool::allocate(64 + i % 512));
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    threads.clear();
+    for (size_t t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&blocks, t]
+        {
+            FakeTopology::node = (t + 1) % 2;
+            for (size_t i = 0; i < blocks[t].size(); ++i) MemoryPool::deallocate(blocks[t][i], 64 + i % 512);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    // 关闭后回到全局中心缓存
+    MemoryPool::disableNuma();
+    std::thread([&]
+    {
+        FakeTopology::node = 1;
+        void* ptr = MemoryPool::allocate(SIZE + 2048);
+        assert(ptr != nullptr && topology.nodeOf(ptr) != 1);
+        MemoryPool::deallocate(ptr, SIZE + 2048);
+    }).join();
+
+    std::cout << "NUMA shard test passed!" << std::endl;
+}
+
+void testPageCacheShards()
+{
+    std::cout << "Running page cache shard test..." << std::endl;
+
+    PageCache& pageCache = PageCache::getInstance();
+
+    // 不同大小类别（以及不切分的请求）并发申请和归还 span，各线程的内存互不重叠
+    std::vector<std::thread> threads;
+    std::atomic<bool> failed{false};
+    for (size_t t = 0; t < 8; ++t)
+    {
+        threads.emplace_back([&pageCache, &failed, t]
+        {
+            size_t objSize = t == 7 ? 0 : (t + 1) * 8;
+            std::vector<std::pair<void*, size_t>> spans;
+            for (size_t i = 0; i < 300; ++i)
+            {
+                size_t pages = 1 + i % 8;
+                void* span = pageCache.allocateSpan(pages, objSize);
+                if (!span || PageCache::getObjectSize(span) != objSize) failed = true;
+                if (!span) continue;
+                memset(span, static_cast<int>(t), pages * PageCache::PAGE_SIZE);
+                spans.emplace_back(span, pages);
+
+                if (i % 3 == 0)
+                {
+                    pageCache.deallocateSpan(spans.front().first, spans.front().second);
+                    spans.erase(spans.begin());
+                }
+            }
+            for (const auto& [span, pages] : spans)
+            {
+                const unsigned char* bytes = static_cast<const unsigned char*>(span);
+                for (size_t j = 0; j < pages * PageCache::PAGE_SIZE; j += 512)
+                {
+                    if (bytes[j] != t) failed = true;
+                }
+                pageCache.deallocateSpan(span, pages);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    assert(!failed);
+
+    // 一个类别归还的 span 可被落在其他分片的类别取用，不再向操作系统申请
+    const size_t PAGES = 4096;
+    void* span = pageCache.allocateSpan(PAGES, 64);
+    assert(span != nullptr);
+    pageCache.deallocateSpan(span, PAGES);
+    [[maybe_unused]] size_t mappedBefore = MemoryPool::getStats().mappedBytes;
+    span = pageCache.allocateSpan(PAGES, 72);
+    assert(span != nullptr);
+    assert(MemoryPool::getStats().mappedBytes == mappedBefore);
+    pageCache.deallocateSpan(span, PAGES);
+
+    std::cout << "Page cache shard test passed!" << std::endl;
+}
+
+void testCacheColoring()
+{
+    std::cout << "Running cache coloring test..." << std::endl;
+
+    // 独立堆的中心缓存从头开始轮换颜色：相继切分的 slab 第一个内存块偏移不同，且都在 span 之内
+    {
+        Heap heap;
+        const size_t SIZE = 448;
+        std::vector<void*> ptrs;
+        std::vector<size_t> colors;
+        for (size_t i = 0; i < 600; ++i)
+        {
+            void* ptr = heap.allocate(SIZE);
+            assert(ptr != nullptr);
+            memset(ptr, 0x5a, SIZE);
+            ptrs.push_back(ptr);
+
+            Span* span = PageCache::mapObjectToSpan(ptr);
+            assert(span && span->objSize == SIZE);
+            [[maybe_unused]] size_t offset = static_cast<char*>(ptr) - static_cast<char*>(span->pageAddr);
+            assert(offset >= span->color && (offset - span->color) % SIZE == 0);
+            assert(offset + SIZE <= span->numPages * PageCache::PAGE_SIZE);
+            if (std::find(colors.begin(), colors.end(), span->color) == colors.end()) colors.push_back(span->color);
+        }
+        assert(colors.size() > 1);
+        for (void* ptr : ptrs) heap.deallocate(ptr, SIZE);
+    }
+
+    // 着色不破坏按大小取整实现的对齐分配
+    for (size_t alignment = 16; alignment <= PageCache::PAGE_SIZE; alignment *= 2)
+    {
+        std::vector<void*> ptrs;
+        for (size_t i = 0; i < 64; ++i)
+        {
+            void* ptr = MemoryPool::allocate(alignment + 8, alignment);
+            assert(ptr != nullptr);
+            assert(reinterpret_cast<uintptr_t>(ptr) % alignment == 0);
+            ptrs.push_back(ptr);
+        }
+        for (void* ptr : ptrs) MemoryPool::deallocate(ptr, alignment + 8, alignment);
+    }
+
+    std::cout << "Cache coloring test passed!" << std::endl;
+}
+
+void testHeapProfiler()
+{
+    std::cout << "Running heap profiler test..." << std::endl;
+
+    // 采样间隔设得很小，使测试中必然有对象被抽中
+    HeapProfiler::start(4096);
+
+    const size_t NUM_ALLOCS = 2000;
+    std::vector<void*> ptrs;
+    for (size_t i = 0; i < NUM_ALLOCS; ++i)
+    {
+        void* ptr = MemoryPool::allocate(128);
+        memset(ptr, 0xab, 128);
+        ptrs.push_back(ptr);
+    }
+    void* large = MemoryPool::allocate(MAX_BYTES * 2);
+    memset(large, 0xcd, MAX_BYTES * 2);
+
+    auto samples = HeapProfiler::getSamples();
+    assert(!samples.empty());
+    for ([[maybe_unused]] const auto& sample : samples)
+    {
+        assert(HeapProfiler::isSampled(sample.ptr));
+        assert(sample.depth > 0);
+        // 采样对象按页对齐，且可正常读写
+        assert(reinterpret_cast<uintptr_t>(sample.ptr) % PageCache::PAGE_SIZE == 0);
+    }
+
+    // 输出 pprof 格式
+    FILE* out = tmpfile();
+    assert(out != nullptr);
+    HeapProfiler::dump(out);
+    rewind(out);
+    char header[64] = {};
+    [[maybe_unused]] char* line = fgets(header, sizeof(header), out);
+    assert(line != nullptr);
+    assert(strncmp(header, "heap profile:", 13) == 0);
+    fclose(out);
+
+    HeapProfiler::stop();
+
+    // 停止后采样对象仍可正常释放，包括不带大小的释放
+    for (size_t i = 0; i < ptrs.size(); ++i)
+    {
+        if (i % 2) MemoryPool::deallocate(ptrs[i], 128);
+        else MemoryPool::deallocate(ptrs[i]);
+    }
+    MemoryPool::deallocate(large, MAX_BYTES * 2);
+    assert(HeapProfiler::getSamples().empty());
+
+    std::cout << "Heap profiler test passed!" << std::endl;
+}
+
+void testAllocTrace()
+{
+    std::cout << "Running alloc trace test..." << std::endl;
+
+    char path[] = "/tmp/memory_pool_traceXXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+
+    [[maybe_unused]] bool started = AllocTrace::start(path);
+    assert(started);
+
+    // 两个线程各记录一组分配/释放，其中一个线程在 stop() 之前退出
+    const size_t EVENTS_PER_THREAD = 10000; // 超过单个线程缓冲区容量，覆盖中途写出
+    auto worker = [&]()
+    {
+        for (size_t i = 0; i < EVENTS_PER_THREAD / 2; ++i)
+        {
+            void* ptr = MemoryPool::allocate(64);
+            AllocTrace::record(AllocTrace::OP_ALLOC, ptr, 64);
+            AllocTrace::record(AllocTrace::OP_FREE, ptr, 64);
+            MemoryPool::deallocate(ptr, 64);
+        }
+    };
+    std::thread exited(worker);
+    exited.join();
+    worker();
+
+    AllocTrace::stop();
+    AllocTrace::record(AllocTrace::OP_ALLOC, nullptr, 1); // 停止后不再记录
+
+    std::vector<AllocTrace::Event> events;
+    [[maybe_unused]] bool read = AllocTrace::readLog(path, events);
+    assert(read);
+    unlink(path);
+
+    // 编译时开启 MEMORY_POOL_TRACE 时 MemoryPool 自身也会记录同样多的事件
+#ifdef MEMORY_POOL_TRACE
+    assert(events.size() == 4 * EVENTS_PER_THREAD);
+#else
+    assert(events.size() == 2 * EVENTS_PER_THREAD);
+#endif
+
+    size_t allocs = 0;
+    uint32_t firstThread = events.front().thread;
+    [[maybe_unused]] bool sawOtherThread = false;
+    for (const auto& event : events)
+    {
+        assert(event.op == AllocTrace::OP_ALLOC || event.op == AllocTrace::OP_FREE);
+        assert(event.size == 64);
+        if (event.op == AllocTrace::OP_ALLOC) allocs++;
+        if (event.thread != firstThread) sawOtherThread = true;
+    }
+    assert(allocs * 2 == events.size());
+    assert(sawOtherThread);
+
+    std::cout << "Alloc trace test passed!" << std::endl;
+}
+
+void testInstrument()
+{
+    std::cout << "Running instrument test..." << std::endl;
+
+    Instrument::reset();
+
+    // 直接记录：0 周期落在第 0 档，5 周期落在 [4, 8) 档
+    Instrument::record(Probe::SYSTEM_ALLOC, 0);
+    Instrument::record(Probe::SYSTEM_ALLOC, 5);
+    std::thread([]() { Instrument::record(Probe::SYSTEM_ALLOC, 1000); }).join();
+
+    Instrument::Histogram merged[Instrument::NUM_PROBES];
+    Instrument::merge(merged);
+    [[maybe_unused]] const Instrument::Histogram& h = merged[static_cast<int>(Probe::SYSTEM_ALLOC)];
+    assert(h.count == 3);
+    assert(h.buckets[0] == 1);
+    assert(h.buckets[3] == 1);
+    assert(h.buckets[10] == 1); // 1000 在 [512, 1024) 内
+    assert(h.maxCycles == 1000);
+    assert(h.totalCycles == 1005);
+
+#ifdef MEMORY_POOL_INSTRUMENT
+    // 开启计时编译时，分配/释放会记录快速路径耗时
+    void* ptr = MemoryPool::allocate(48);
+    MemoryPool::deallocate(ptr, 48);
+    ptr = MemoryPool::allocate(48);
+    MemoryPool::deallocate(ptr, 48);
+    Instrument::merge(merged);
+    assert(merged[static_cast<int>(Probe::THREAD_CACHE_ALLOC)].count >= 1);
+    assert(merged[static_cast<int>(Probe::THREAD_CACHE_FREE)].count >= 1);
+#endif
+
+    FILE* out = tmpfile();
+    assert(out != nullptr);
+    Instrument::dump(out);
+    assert(ftell(out) > 0);
+    fclose(out);
+
+    Instrument::reset();
+    std::cout << "Instrument test passed!" << std::endl;
+}
+
 int main()
 {
     try
@@ -189,6 +1620,27 @@ int main()
         testMultiThreading(); // 运行多线程测试
         testEdgeCases(); // 运行边界测试
         testStress(); // 运行压力测试
+        testPoolAllocator(); // 运行分配器适配器测试
+        testObjectPool(); // 运行对象池测试
+        testBatchAllocation(); // 运行批量分配测试
+        testCrossThreadFree(); // 运行跨线程释放测试
+        testRemoteFreeOwner(); // 运行远程释放所属者测试
+        testStats(); // 运行统计测试
+        testThreadCacheDecay(); // 运行线程缓存衰减测试
+        testAsyncRefill(); // 运行异步补充测试
+        testHeap(); // 运行独立堆测试
+        testArena(); // 运行单调内存区测试
+        testRealtime(); // 运行实时模式测试
+        testPrewarm(); // 运行线程缓存预热测试
+        testPersistentHeap(); // 运行持久化堆测试
+        testSharedPool(); // 运行共享内存池测试
+        testMemoryLimit(); // 运行内存限制测试
+        testNuma(); // 运行 NUMA 分片测试
+        testPageCacheShards(); // 运行页缓存分片测试
+        testCacheColoring(); // 运行缓存着色测试
+        testHeapProfiler(); // 运行采样堆分析器测试
+        testAllocTrace(); // 运行分配轨迹记录测试
+        testInstrument(); // 运行分层计时测试
 
         std::cout << "All tests passed successfully!" << std::endl; // 如果所有测试都通过，则打印成功信息
         return 0; // 返回 0 表示程序成功执行